@@ -0,0 +1,1064 @@
+/**
+ * @brief Benchmarks of xml_tree, one case for each feature measured.
+ *
+ * @note  (1) Run "bench <case> [size]", or "bench" to list the cases and
+ *            their default size (mostly number of batches).
+ *
+ *        (2) Name and value files are made by the generator below in the
+ *            current directory as bench_*.xml, and reused by later runs.
+ *
+ *        (3) Allocations are counted by replacing global operator new,
+ *            peak RSS is read by getrusage() (not on Windows).
+ */
+#define EN_LogMsg 0u // logs would be timed too.
+#include "xml_tree.hpp"
+#include <stdlib.h>
+#include <math.h>
+#include <chrono>
+#include <string>
+#if !defined(_WIN32)
+  #include <sys/resource.h>
+  #include <sys/wait.h>
+  #include <unistd.h>
+#endif
+
+namespace bench
+{
+  std::atomic<size_t> n_allocNum(0);              // Number of calls of operator new.
+}
+
+#if defined(__GNUC__)
+  #define BENCH_NoInline __attribute__((noinline)) // inlined into a delete expression, gcc warns free() of operator new.
+#else
+  #define BENCH_NoInline
+#endif
+
+BENCH_NoInline void* operator new(size_t n_size)
+{
+  bench::n_allocNum.fetch_add(1, std::memory_order_relaxed);
+  void *p_block = malloc(n_size == 0 ? 1 : n_size);
+  if(p_block == NULL) throw std::bad_alloc();
+  return p_block;
+}
+
+BENCH_NoInline void operator delete(void* p_block) noexcept
+{
+  free(p_block);
+}
+
+namespace bench
+{
+  using namespace xml_tree;
+
+  typedef std::chrono::steady_clock Bench_Clock_t;
+
+  double get_ms(Bench_Clock_t::time_point t_begin)
+  {
+    return std::chrono::duration<double, std::milli>(Bench_Clock_t::now() - t_begin).count();
+  }
+
+  /**
+   * @ret return peak RSS of the process in KB, 0 if unknown.
+   */
+  long get_peakRss()
+  {
+#if defined(_WIN32)
+    return 0;
+#else
+    struct rusage s_usage;
+    getrusage(RUSAGE_SELF, &s_usage);
+    return s_usage.ru_maxrss;
+#endif
+  }
+
+  bool has_file(const std::string &str_file)
+  {
+    FILE *p_file = fopen(str_file.c_str(), "rb");
+    if(p_file == NULL) return false;
+    fclose(p_file);
+    return true;
+  }
+
+  /**
+   * @brief This func write a name file of items "class" -> "student" ->
+   *        "weight", "height", "score", and n_group more items under root
+   *        with 15 "field" items each, for a wide schema.
+   *
+   * @ret   return name of file.
+   */
+  std::string make_names(size_t n_group)
+  {
+    char str_file[64];
+    snprintf(str_file, sizeof(str_file), "bench_name_%u.xml", (unsigned)n_group);
+    if(has_file(str_file)) return str_file;
+
+    FILE *p_file = fopen(str_file, "wb");
+    fprintf(p_file, "<?xml version=\"1.0\"?>\n<root>\n");
+    fprintf(p_file, "<Content index=\"1\" name=\"class\">\n<Content index=\"1\" name=\"student\">\n");
+    fprintf(p_file, "<Content index=\"1\" name=\"weight\"></Content>\n");
+    fprintf(p_file, "<Content index=\"2\" name=\"height\"></Content>\n");
+    fprintf(p_file, "<Content index=\"3\" name=\"score\"></Content>\n");
+    fprintf(p_file, "</Content>\n</Content>\n");
+    for(size_t m = 0; m < n_group; m++)
+    {
+      fprintf(p_file, "<Content index=\"%u\" name=\"group%u\">\n", (unsigned)(m + 2), (unsigned)m);
+      for(size_t n = 0; n < 15; n++)
+      {
+        fprintf(p_file, "<Content index=\"%u\" name=\"field%u_%u\"></Content>\n", (unsigned)(n + 1), (unsigned)m, (unsigned)n);
+      }
+      fprintf(p_file, "</Content>\n");
+    }
+    fprintf(p_file, "</root>\n");
+    fclose(p_file);
+    return str_file;
+  }
+
+  /**
+   * @brief This func write a value file of n_batch batches from index
+   *        n_first, each with "class" (20 strings), "weight" (500 values),
+   *        "height" (mostly distinct), "score" (int), and n_field more int
+   *        members "field*" of the wide schema.
+   *
+   * @ret   return name of file.
+   */
+  std::string make_values(size_t n_batch, size_t n_first = 1, size_t n_field = 0)
+  {
+    char str_file[96];
+    snprintf(str_file, sizeof(str_file), "bench_val_%u_%u_%u.xml", (unsigned)n_batch, (unsigned)n_first, (unsigned)n_field);
+    if(has_file(str_file)) return str_file;
+
+    FILE *p_file = fopen(str_file, "wb");
+    fprintf(p_file, "<?xml version=\"1.0\"?>\n<root>\n");
+    uint32_t n_seed = 12345;
+    for(size_t m = 0; m < n_batch; m++)
+    {
+      n_seed = n_seed * 1103515245u + 12345u;
+      uint32_t n_rand = n_seed >> 8;
+      fprintf(p_file, "<Batch index=\"%u\">\n", (unsigned)(n_first + m));
+      fprintf(p_file, "<Member name=\"class\" type=\"string\">Class %u</Member>\n", (unsigned)(m % 20));
+      fprintf(p_file, "<Member name=\"weight\" type=\"double\">%.1f</Member>\n", 40.0 + (n_rand % 500) / 10.0);
+      fprintf(p_file, "<Member name=\"height\" type=\"double\">%.4f</Member>\n", 1.4 + (n_rand % 600000) / 1000000.0);
+      fprintf(p_file, "<Member name=\"score\" type=\"int\">%u</Member>\n", (unsigned)(n_rand % 1000000));
+      for(size_t n = 0; n < n_field; n++)
+      {
+        fprintf(p_file, "<Member name=\"field%u_%u\" type=\"int\">%u</Member>\n", (unsigned)(n / 15), (unsigned)(n % 15), (unsigned)((n_rand >> (n % 8)) % 100));
+      }
+      fprintf(p_file, "</Batch>\n");
+    }
+    fprintf(p_file, "</root>\n");
+    fclose(p_file);
+    return str_file;
+  }
+
+  void free_batchMap(std::map<std::string, Tree_Val_t*> &m_batch)
+  {
+    for(auto iter = m_batch.begin(); iter != m_batch.end(); ++iter)
+    {
+      if(iter->second->e_type == VAL_String) delete[] iter->second->u_val.val_string;
+      delete iter->second;
+    }
+    m_batch.clear();
+  }
+
+  void free_itemMap(std::map<uint32_t, Tree_Val_t*> &m_item)
+  {
+    for(auto iter = m_item.begin(); iter != m_item.end(); ++iter)
+    {
+      if(iter->second->e_type == VAL_String) delete[] iter->second->u_val.val_string;
+      delete iter->second;
+    }
+    m_item.clear();
+  }
+
+  /**
+   * @brief Load n/8, n/4, n/2 and n batches of mostly distinct heights,
+   *        time per batch stays flat if loading is linear.
+   */
+  int run_load(size_t n_batch)
+  {
+    std::string str_name = make_names(0);
+    for(size_t n_div = 8; n_div >= 1; n_div /= 2)
+    {
+      size_t n_num = n_batch / n_div;
+      std::string str_val = make_values(n_num);
+      xmlTree s_tree;
+      s_tree.build_tree_fromXmlFile(str_name.c_str());
+      Bench_Clock_t::time_point t_begin = Bench_Clock_t::now();
+      int ret = s_tree.add_batch_fromXmlFile(str_val.c_str());
+      double d_ms = get_ms(t_begin);
+      printf("load %8u batches: %9.1f ms, %6.3f us/batch, ret %d\n", (unsigned)n_num, d_ms, d_ms * 1000 / n_num, ret);
+    }
+    return 0;
+  }
+
+  /**
+   * @note  Item of schema linked by pointers, searched like the recursive
+   *        name search the tree used before its name index.
+   */
+  struct Bench_NameNode_t
+  {
+    std::string str_name;
+    std::vector<Bench_NameNode_t *> v_child;
+  };
+
+  void build_nameNode(rapidxml::xml_node<> *node_parent, Bench_NameNode_t *p_parent, std::vector<std::string> &v_name)
+  {
+    for(rapidxml::xml_node<> *node_child = node_parent->first_node("Content"); node_child != NULL; node_child = node_child->next_sibling("Content"))
+    {
+      Bench_NameNode_t *p_child = new Bench_NameNode_t;
+      p_child->str_name = node_child->first_attribute("name")->value();
+      p_parent->v_child.push_back(p_child);
+      v_name.push_back(p_child->str_name);
+      build_nameNode(node_child, p_child, v_name);
+    }
+  }
+
+  void free_nameNode(Bench_NameNode_t *p_node)
+  {
+    for(size_t m = 0; m < p_node->v_child.size(); m++)
+    {
+      free_nameNode(p_node->v_child[m]);
+      delete p_node->v_child[m];
+    }
+  }
+
+  const Bench_NameNode_t *search_nameNode(const Bench_NameNode_t *p_parent, const char *str_name)
+  {
+    const Bench_NameNode_t *p_found = NULL;
+    for(size_t m = 0; (m < p_parent->v_child.size()) && (p_found == NULL); m++)
+    {
+      p_found = search_nameNode(p_parent->v_child[m], str_name);
+      if(!strcmp(p_parent->v_child[m]->str_name.c_str(), str_name))
+      {
+        p_found = p_parent->v_child[m];
+      }
+    }
+    return p_found;
+  }
+
+  /**
+   * @brief Look up n_lookup random names of a schema with 229 items, by the
+   *        recursive search and by get_itemHandle().
+   */
+  int run_names(size_t n_lookup)
+  {
+    std::string str_name = make_names(14);
+    xmlTree s_tree;
+    s_tree.build_tree_fromXmlFile(str_name.c_str());
+
+    rapidxml::file<> xml_file(str_name.c_str());
+    rapidxml::xml_document<> xml_doc;
+    xml_doc.parse<0>(xml_file.data());
+    Bench_NameNode_t s_root;
+    std::vector<std::string> v_name;
+    build_nameNode(xml_doc.first_node(), &s_root, v_name);
+
+    std::vector<const char *> v_lookup(n_lookup);
+    uint32_t n_seed = 1;
+    for(size_t m = 0; m < n_lookup; m++)
+    {
+      n_seed = n_seed * 1103515245u + 12345u;
+      v_lookup[m] = v_name[(n_seed >> 8) % v_name.size()].c_str();
+    }
+
+    size_t n_found = 0;
+    Bench_Clock_t::time_point t_begin = Bench_Clock_t::now();
+    for(size_t m = 0; m < n_lookup; m++)
+    {
+      n_found += (search_nameNode(&s_root, v_lookup[m]) != NULL);
+    }
+    double d_recursive = get_ms(t_begin);
+
+    t_begin = Bench_Clock_t::now();
+    for(size_t m = 0; m < n_lookup; m++)
+    {
+      n_found += (s_tree.get_itemHandle(v_lookup[m]) != NULL);
+    }
+    double d_hash = get_ms(t_begin);
+
+    printf("%u items, %u lookups, found %u\n", (unsigned)v_name.size(), (unsigned)n_lookup, (unsigned)n_found);
+    printf("recursive search: %9.1f ms, %8.1f ns/lookup\n", d_recursive, d_recursive * 1e6 / n_lookup);
+    printf("name index:       %9.1f ms, %8.1f ns/lookup\n", d_hash, d_hash * 1e6 / n_lookup);
+    free_nameNode(&s_root);
+    return 0;
+  }
+
+  /**
+   * @brief Restore a tree of n_batch batches from xml files and from a
+   *        snapshot of it, and check both give the same batch.
+   */
+  int run_snapshot(size_t n_batch)
+  {
+    std::string str_name = make_names(0);
+    std::string str_val = make_values(n_batch);
+    const char *str_snapshot = "bench_snapshot.bin";
+
+    Bench_Clock_t::time_point t_begin = Bench_Clock_t::now();
+    xmlTree *p_xmlTree = new xmlTree;
+    int ret = p_xmlTree->build_tree_fromXmlFile(str_name.c_str());
+    if(ret == ERR_None) ret = p_xmlTree->add_batch_fromXmlFile(str_val.c_str());
+    double d_xml = get_ms(t_begin);
+
+    t_begin = Bench_Clock_t::now();
+    if(ret == ERR_None) ret = p_xmlTree->save_snapshot(str_snapshot);
+    double d_save = get_ms(t_begin);
+
+    t_begin = Bench_Clock_t::now();
+    xmlTree *p_snapTree = new xmlTree;
+    if(ret == ERR_None) ret = p_snapTree->load_snapshot(str_snapshot);
+    double d_snapshot = get_ms(t_begin);
+
+    std::map<std::string, Tree_Val_t*> m_xmlBatch, m_snapBatch;
+    p_xmlTree->get_oneBatchValue((uint32_t)n_batch, m_xmlBatch);
+    p_snapTree->get_oneBatchValue((uint32_t)n_batch, m_snapBatch);
+    bool is_same = (m_xmlBatch.size() == m_snapBatch.size());
+    for(auto iter = m_xmlBatch.begin(); is_same && (iter != m_xmlBatch.end()); ++iter)
+    {
+      auto iter_snap = m_snapBatch.find(iter->first);
+      is_same = (iter_snap != m_snapBatch.end()) && (iter_snap->second->e_type == iter->second->e_type)
+                && ((iter->second->e_type == VAL_None) || (*iter_snap->second == *iter->second));
+    }
+    free_batchMap(m_xmlBatch);
+    free_batchMap(m_snapBatch);
+    delete p_xmlTree;
+    delete p_snapTree;
+    remove(str_snapshot);
+
+    printf("%u batches, ret %d, same last batch: %s\n", (unsigned)n_batch, ret, is_same ? "yes" : "no");
+    printf("xml ingest:    %9.1f ms\n", d_xml);
+    printf("save snapshot: %9.1f ms\n", d_save);
+    printf("load snapshot: %9.1f ms\n", d_snapshot);
+    return ret;
+  }
+
+  /**
+   * @note  Member stored the way the tree did before its arena: one new for
+   *        the member, one for a string value and nodes of a std::set of
+   *        batch indexes, kept in a std::list of the item.
+   */
+  struct Bench_OldMember_t
+  {
+    Tree_Val_t s_val;
+    std::set<uint32_t> set_batchIndex;
+  };
+
+  struct Bench_OldItem_t
+  {
+    std::list<Bench_OldMember_t *> l_member;
+    std::unordered_map<std::string, Bench_OldMember_t *> um_member;   // Value text to member.
+  };
+
+  /**
+   * @brief Read the value file made by make_values() line by line into
+   *        items of Bench_OldItem_t.
+   */
+  int load_oldStyle(const std::string &str_val, std::unordered_map<std::string, Bench_OldItem_t> &um_item)
+  {
+    FILE *p_file = fopen(str_val.c_str(), "rb");
+    if(p_file == NULL) return ERR_OpenFile;
+
+    char str_line[256];
+    uint32_t n_batchIndex = 0;
+    while(fgets(str_line, sizeof(str_line), p_file) != NULL)
+    {
+      char str_itemName[64], str_type[16], str_text[64];
+      if(sscanf(str_line, "<Batch index=\"%u\">", &n_batchIndex) == 1) continue;
+      if(sscanf(str_line, "<Member name=\"%63[^\"]\" type=\"%15[^\"]\">%63[^<]", str_itemName, str_type, str_text) != 3) continue;
+
+      Bench_OldItem_t &s_item = um_item[str_itemName];
+      auto iter = s_item.um_member.find(str_text);
+      if(iter == s_item.um_member.end())
+      {
+        Bench_OldMember_t *p_member = new Bench_OldMember_t;
+        if(!strcmp(str_type, "string"))
+        {
+          p_member->s_val.e_type = VAL_String;
+          p_member->s_val.n_memLen = strlen(str_text) + 1;
+          p_member->s_val.u_val.val_string = new char[p_member->s_val.n_memLen];
+          memcpy(p_member->s_val.u_val.val_string, str_text, p_member->s_val.n_memLen);
+        }
+        else if(!strcmp(str_type, "int"))
+        {
+          p_member->s_val.e_type = VAL_Int;
+          p_member->s_val.u_val.val_int = atoi(str_text);
+        }
+        else
+        {
+          p_member->s_val.e_type = VAL_Double;
+          p_member->s_val.u_val.val_double = atof(str_text);
+        }
+        s_item.l_member.push_back(p_member);
+        iter = s_item.um_member.insert(std::make_pair(std::string(str_text), p_member)).first;
+      }
+      iter->second->set_batchIndex.insert(n_batchIndex);
+    }
+    fclose(p_file);
+    return ERR_None;
+  }
+
+  /**
+   * @brief Load n_batch batches old-style (mode 0) or into the tree
+   *        (mode 1), print time, allocations and peak RSS of the process.
+   */
+  int run_arenaMode(size_t n_batch, int n_mode, const std::string &str_name, const std::string &str_val)
+  {
+    int ret = ERR_None;
+    size_t n_allocBegin = n_allocNum.load();
+    Bench_Clock_t::time_point t_begin = Bench_Clock_t::now();
+    if(n_mode == 0)
+    {
+      std::unordered_map<std::string, Bench_OldItem_t> um_item;
+      ret = load_oldStyle(str_val, um_item);
+      printf("old-style members: %9.1f ms, %9u allocs, peak RSS %8ld KB, ret %d\n",
+             get_ms(t_begin), (unsigned)(n_allocNum.load() - n_allocBegin), get_peakRss(), ret);
+      for(auto iter = um_item.begin(); iter != um_item.end(); ++iter)
+      {
+        for(auto iter_member = iter->second.l_member.begin(); iter_member != iter->second.l_member.end(); ++iter_member)
+        {
+          if((*iter_member)->s_val.e_type == VAL_String) delete[] (*iter_member)->s_val.u_val.val_string;
+          delete *iter_member;
+        }
+      }
+    }
+    else
+    {
+      xmlTree s_tree;
+      ret = s_tree.build_tree_fromXmlFile(str_name.c_str());
+      if(ret == ERR_None) ret = s_tree.add_batch_fromXmlStream(str_val.c_str());
+      printf("arena tree:        %9.1f ms, %9u allocs, peak RSS %8ld KB, ret %d\n",
+             get_ms(t_begin), (unsigned)(n_allocNum.load() - n_allocBegin), get_peakRss(), ret);
+    }
+    fflush(stdout);
+    return ret;
+  }
+
+  /**
+   * @brief Load n_batch batches with old-style members and into the arena
+   *        backed tree, each in its own process so peak RSS is its own.
+   */
+  int run_arena(size_t n_batch)
+  {
+    std::string str_name = make_names(0);
+    std::string str_val = make_values(n_batch);
+    printf("%u batches, file read line by line in both\n", (unsigned)n_batch);
+    fflush(stdout);
+    int ret = ERR_None;
+    for(int n_mode = 0; n_mode < 2; n_mode++)
+    {
+#if defined(_WIN32)
+      ret |= run_arenaMode(n_batch, n_mode, str_name, str_val);
+#else
+      pid_t n_pid = fork();
+      if(n_pid == 0)
+      {
+        _exit(run_arenaMode(n_batch, n_mode, str_name, str_val));
+      }
+      int n_status = 1;
+      if((n_pid < 0) || (waitpid(n_pid, &n_status, 0) != n_pid) || !WIFEXITED(n_status) || (WEXITSTATUS(n_status) != 0))
+      {
+        ret = 1;
+      }
+#endif
+    }
+    return ret;
+  }
+
+  /**
+   * @brief Time n_repeat range queries on "height" by query_oneItem() and
+   *        by a scan of for_each_in_item(), print ms per query.
+   */
+  void time_range(const xmlTree &s_tree, const char *str_desc, double d_low, double d_high, size_t n_repeat)
+  {
+    xmlTree::Tree_Handle_t h_height = s_tree.get_itemHandle("height");
+    Tree_Pred_t s_pred = make_betweenPred(make_doubleVal(d_low), make_doubleVal(d_high));
+    uint64_t n_query = 0, n_scan = 0;
+
+    Bench_Clock_t::time_point t_begin = Bench_Clock_t::now();
+    for(size_t m = 0; m < n_repeat; m++)
+    {
+      Tree_Bitmap_t bm_result;
+      s_tree.query_oneItem(h_height, s_pred, bm_result);
+      n_query = bm_result.cardinality();
+    }
+    double d_query = get_ms(t_begin) / n_repeat;
+
+    t_begin = Bench_Clock_t::now();
+    for(size_t m = 0; m < n_repeat; m++)
+    {
+      Tree_Bitmap_t bm_result;
+      s_tree.for_each_in_item(h_height, [&](uint32_t batch_index, const Tree_ValView_t &s_val){
+        if((s_val.u_val.val_double >= d_low) && (s_val.u_val.val_double <= d_high)) bm_result.add(batch_index);
+      });
+      n_scan = bm_result.cardinality();
+    }
+    double d_scan = get_ms(t_begin) / n_repeat;
+
+    printf("%-22s %8u hits: query %8.3f ms, scan %8.3f ms%s\n", str_desc, (unsigned)n_query, d_query, d_scan,
+           (n_query == n_scan) ? "" : " (hits differ)");
+  }
+
+  /**
+   * @brief Range queries on n_batch mostly distinct heights, selective
+   *        (~0.1%) and wide (~50%), before and after optimize().
+   */
+  int run_range(size_t n_batch)
+  {
+    std::string str_name = make_names(0);
+    std::string str_val = make_values(n_batch);
+    xmlTree s_tree;
+    s_tree.build_tree_fromXmlFile(str_name.c_str());
+    int ret = s_tree.add_batch_fromXmlFile(str_val.c_str());
+
+    printf("%u batches, ret %d\n", (unsigned)n_batch, ret);
+    time_range(s_tree, "selective, dictionary", 1.7, 1.7006, 20);
+    time_range(s_tree, "wide, dictionary", 1.4, 1.7, 20);
+    s_tree.optimize();
+    time_range(s_tree, "selective, optimized", 1.7, 1.7006, 20);
+    time_range(s_tree, "wide, optimized", 1.4, 1.7, 20);
+    return ret;
+  }
+
+  /**
+   * @brief Average height per class of n_batch batches by group_byItem(),
+   *        and by a loop of get_oneBatchValue() over all batches.
+   */
+  int run_groupby(size_t n_batch)
+  {
+    std::string str_name = make_names(0);
+    std::string str_val = make_values(n_batch);
+    xmlTree s_tree;
+    s_tree.build_tree_fromXmlFile(str_name.c_str());
+    int ret = s_tree.add_batch_fromXmlStream(str_val.c_str());
+
+    std::vector<Tree_Group_t> v_group;
+    Bench_Clock_t::time_point t_begin = Bench_Clock_t::now();
+    s_tree.group_byItem("class", "height", v_group);
+    double d_groupBy = get_ms(t_begin);
+
+    std::map<std::string, std::pair<double, uint64_t> > m_loop;  // Class to sum and count of heights.
+    t_begin = Bench_Clock_t::now();
+    std::set<uint32_t> set_batch;
+    s_tree.get_batchSet(set_batch);
+    for(auto iter = set_batch.begin(); iter != set_batch.end(); ++iter)
+    {
+      std::map<std::string, Tree_Val_t*> m_batch;
+      s_tree.get_oneBatchValue(*iter, m_batch);
+      auto iter_class = m_batch.find("class");
+      auto iter_height = m_batch.find("height");
+      if((iter_class != m_batch.end()) && (iter_height != m_batch.end()))
+      {
+        std::pair<double, uint64_t> &p_sum = m_loop[iter_class->second->u_val.val_string];
+        p_sum.first += iter_height->second->u_val.val_double;
+        p_sum.second++;
+      }
+      free_batchMap(m_batch);
+    }
+    double d_loop = get_ms(t_begin);
+
+    s_tree.optimize();
+    t_begin = Bench_Clock_t::now();
+    s_tree.group_byItem("class", "height", v_group);
+    double d_optimized = get_ms(t_begin);
+
+    bool is_same = (v_group.size() == m_loop.size());
+    for(size_t m = 0; is_same && (m < v_group.size()); m++)
+    {
+      const std::pair<double, uint64_t> &p_sum = m_loop[v_group[m].s_key.u_val.val_string];
+      is_same = (p_sum.second == v_group[m].n_batchNum) && (fabs(p_sum.first / p_sum.second - v_group[m].s_stat.d_avg) < 1e-9);
+    }
+
+    printf("%u batches, ret %d, %u groups, same averages: %s\n", (unsigned)n_batch, ret, (unsigned)v_group.size(), is_same ? "yes" : "no");
+    printf("group_byItem:            %9.1f ms\n", d_groupBy);
+    printf("get_oneBatchValue loop:  %9.1f ms\n", d_loop);
+    printf("group_byItem, optimized: %9.1f ms\n", d_optimized);
+    return ret;
+  }
+
+  /**
+   * @brief Print count, p50, p99, p999 and max of latencies in us.
+   */
+  void print_latency(const char *str_desc, std::vector<double> &v_us)
+  {
+    if(v_us.empty()) return;
+    std::sort(v_us.begin(), v_us.end());
+    printf("%-28s %8u ops, p50 %8.2f us, p99 %8.2f us, p999 %9.2f us, max %9.2f us\n", str_desc, (unsigned)v_us.size(),
+           v_us[v_us.size() / 2], v_us[v_us.size() * 99 / 100], v_us[v_us.size() * 999 / 1000], v_us.back());
+  }
+
+  /**
+   * @brief Readers of xmlSharedTree for n_ms ms, each gets a random batch,
+   *        and every 1000th time all values of "weight". Latencies of the
+   *        two calls are appended to v_batchUs and v_itemUs.
+   */
+  void run_readers(const xmlSharedTree &s_tree, size_t n_batch, int n_readerNum, int n_ms, std::vector<double> &v_batchUs, std::vector<double> &v_itemUs)
+  {
+    std::vector<std::vector<double> > v_threadBatch(n_readerNum), v_threadItem(n_readerNum);
+    std::vector<std::thread> v_thread;
+    Bench_Clock_t::time_point t_end = Bench_Clock_t::now() + std::chrono::milliseconds(n_ms);
+    for(int m = 0; m < n_readerNum; m++)
+    {
+      v_thread.push_back(std::thread([&, m](){
+        uint32_t n_seed = m + 1;
+        for(size_t n = 1; Bench_Clock_t::now() < t_end; n++)
+        {
+          n_seed = n_seed * 1103515245u + 12345u;
+          Bench_Clock_t::time_point t_begin = Bench_Clock_t::now();
+          if(n % 1000 == 0)
+          {
+            std::map<uint32_t, Tree_Val_t*> m_item;
+            s_tree.get_oneItemValue("weight", m_item);
+            v_threadItem[m].push_back(get_ms(t_begin) * 1000);
+            free_itemMap(m_item);
+          }
+          else
+          {
+            std::map<std::string, Tree_Val_t*> m_batch;
+            s_tree.get_oneBatchValue(1 + (n_seed >> 8) % n_batch, m_batch);
+            v_threadBatch[m].push_back(get_ms(t_begin) * 1000);
+            free_batchMap(m_batch);
+          }
+        }
+      }));
+    }
+    for(int m = 0; m < n_readerNum; m++)
+    {
+      v_thread[m].join();
+      v_batchUs.insert(v_batchUs.end(), v_threadBatch[m].begin(), v_threadBatch[m].end());
+      v_itemUs.insert(v_itemUs.end(), v_threadItem[m].begin(), v_threadItem[m].end());
+    }
+  }
+
+  /**
+   * @brief 4 readers on an xmlSharedTree of n_batch batches for 3 s,
+   *        alone and while a writer adds 100 batches from a file and
+   *        deletes them one by one, over and over.
+   */
+  int run_shared(size_t n_batch)
+  {
+    const int n_readerNum = 4, n_ms = 3000;
+    const size_t n_extra = 100;
+    std::string str_name = make_names(0);
+    std::string str_val = make_values(n_batch);
+    std::string str_extra = make_values(n_extra, n_batch + 1);
+    xmlSharedTree s_tree;
+    s_tree.build_tree_fromXmlFile(str_name.c_str());
+    int ret = s_tree.add_batch_fromXmlFile(str_val.c_str());
+    printf("%u batches, ret %d, %d readers, %u hardware threads\n", (unsigned)n_batch, ret, n_readerNum, std::thread::hardware_concurrency());
+
+    std::vector<double> v_batchUs, v_itemUs;
+    run_readers(s_tree, n_batch, n_readerNum, n_ms, v_batchUs, v_itemUs);
+    printf("readers alone:\n");
+    print_latency("  get_oneBatchValue", v_batchUs);
+    print_latency("  get_oneItemValue", v_itemUs);
+
+    std::atomic<bool> is_stop(false);
+    std::vector<double> v_addUs, v_deleteUs;
+    std::thread s_writer([&](){
+      while(!is_stop.load())
+      {
+        Bench_Clock_t::time_point t_begin = Bench_Clock_t::now();
+        ret |= s_tree.add_batch_fromXmlFile(str_extra.c_str());
+        v_addUs.push_back(get_ms(t_begin) * 1000);
+        for(size_t m = 0; m < n_extra; m++)
+        {
+          t_begin = Bench_Clock_t::now();
+          ret |= s_tree.delete_oneBatch(n_batch + 1 + m);
+          v_deleteUs.push_back(get_ms(t_begin) * 1000);
+        }
+      }
+    });
+    v_batchUs.clear();
+    v_itemUs.clear();
+    run_readers(s_tree, n_batch, n_readerNum, n_ms, v_batchUs, v_itemUs);
+    is_stop.store(true);
+    s_writer.join();
+    printf("readers with a writer, ret %d:\n", ret);
+    print_latency("  get_oneBatchValue", v_batchUs);
+    print_latency("  get_oneItemValue", v_itemUs);
+    print_latency("  add_batch_fromXmlFile(100)", v_addUs);
+    print_latency("  delete_oneBatch", v_deleteUs);
+    return ret;
+  }
+
+  /**
+   * @brief Delete a random 10% of n_batch batches by delete_batches() of a
+   *        set, of a bitmap, and by delete_oneBatch() one at a time, each
+   *        on a freshly loaded tree.
+   */
+  int run_delete(size_t n_batch)
+  {
+    std::string str_name = make_names(0);
+    std::string str_val = make_values(n_batch);
+    std::set<uint32_t> set_delete;
+    uint32_t n_seed = 7;
+    while(set_delete.size() < n_batch / 10)
+    {
+      n_seed = n_seed * 1103515245u + 12345u;
+      set_delete.insert(1 + (n_seed >> 8) % n_batch);
+    }
+    Tree_Bitmap_t bm_delete;
+    for(auto iter = set_delete.begin(); iter != set_delete.end(); ++iter)
+    {
+      bm_delete.add(*iter);
+    }
+
+    const char *arr_desc[] = {"delete_batches(set)", "delete_batches(bitmap)", "delete_oneBatch loop"};
+    int ret = ERR_None;
+    printf("%u batches, deleting %u\n", (unsigned)n_batch, (unsigned)set_delete.size());
+    for(int n_mode = 0; n_mode < 3; n_mode++)
+    {
+      xmlTree s_tree;
+      s_tree.build_tree_fromXmlFile(str_name.c_str());
+      ret |= s_tree.add_batch_fromXmlFile(str_val.c_str());
+
+      Bench_Clock_t::time_point t_begin = Bench_Clock_t::now();
+      if(n_mode == 0)
+      {
+        ret |= s_tree.delete_batches(set_delete);
+      }
+      else if(n_mode == 1)
+      {
+        ret |= s_tree.delete_batches(bm_delete);
+      }
+      else
+      {
+        for(auto iter = set_delete.begin(); iter != set_delete.end(); ++iter)
+        {
+          ret |= s_tree.delete_oneBatch(*iter);
+        }
+      }
+      double d_ms = get_ms(t_begin);
+
+      std::set<uint32_t> set_batch;
+      s_tree.get_batchSet(set_batch);
+      printf("%-22s %9.1f ms, %u batches left, ret %d\n", arr_desc[n_mode], d_ms, (unsigned)set_batch.size(), ret);
+    }
+    return ret;
+  }
+
+  /**
+   * @brief Print time and allocations since t_begin and n_allocBegin, per
+   *        call of n_call calls.
+   */
+  void print_calls(const char *str_desc, Bench_Clock_t::time_point t_begin, size_t n_allocBegin, size_t n_call)
+  {
+    double d_ms = get_ms(t_begin);
+    size_t n_alloc = n_allocNum.load() - n_allocBegin;
+    printf("%-26s %9.1f ms, %10.3f us/call, %10u allocs, %9.2f allocs/call\n", str_desc, d_ms, d_ms * 1000 / n_call,
+           (unsigned)n_alloc, (double)n_alloc / n_call);
+  }
+
+  /**
+   * @brief Read every batch of n_batch batches, and all values of "height"
+   *        a few times, as maps of copied values and as views.
+   */
+  int run_views(size_t n_batch)
+  {
+    std::string str_name = make_names(0);
+    std::string str_val = make_values(n_batch);
+    xmlTree s_tree;
+    s_tree.build_tree_fromXmlFile(str_name.c_str());
+    int ret = s_tree.add_batch_fromXmlFile(str_val.c_str());
+    printf("%u batches, ret %d\n", (unsigned)n_batch, ret);
+
+    size_t n_allocBegin = n_allocNum.load();
+    Bench_Clock_t::time_point t_begin = Bench_Clock_t::now();
+    for(uint32_t m = 1; m <= n_batch; m++)
+    {
+      std::map<std::string, Tree_Val_t*> m_batch;
+      s_tree.get_oneBatchValue(m, m_batch);
+      free_batchMap(m_batch);
+    }
+    print_calls("get_oneBatchValue", t_begin, n_allocBegin, n_batch);
+
+    std::vector<xmlTree::Tree_ItemView_t> v_batch;
+    n_allocBegin = n_allocNum.load();
+    t_begin = Bench_Clock_t::now();
+    for(uint32_t m = 1; m <= n_batch; m++)
+    {
+      s_tree.get_oneBatchView(m, v_batch);
+    }
+    print_calls("get_oneBatchView", t_begin, n_allocBegin, n_batch);
+
+    const size_t n_itemCall = 5;
+    n_allocBegin = n_allocNum.load();
+    t_begin = Bench_Clock_t::now();
+    for(size_t m = 0; m < n_itemCall; m++)
+    {
+      std::map<uint32_t, Tree_Val_t*> m_item;
+      s_tree.get_oneItemValue("height", m_item);
+      free_itemMap(m_item);
+    }
+    print_calls("get_oneItemValue(height)", t_begin, n_allocBegin, n_itemCall);
+
+    std::vector<Tree_BatchView_t> v_item;
+    xmlTree::Tree_Handle_t h_height = s_tree.get_itemHandle("height");
+    n_allocBegin = n_allocNum.load();
+    t_begin = Bench_Clock_t::now();
+    for(size_t m = 0; m < n_itemCall; m++)
+    {
+      s_tree.get_oneItemView(h_height, v_item);
+    }
+    print_calls("get_oneItemView(height)", t_begin, n_allocBegin, n_itemCall);
+    return ret;
+  }
+
+  /**
+   * @brief Sum all heights of n_batch batches by get_oneItemValue() and by
+   *        for_each_in_item(), and the numbers of every batch by
+   *        get_oneBatchValue() and by for_each_in_batch().
+   */
+  int run_foreach(size_t n_batch)
+  {
+    std::string str_name = make_names(0);
+    std::string str_val = make_values(n_batch);
+    xmlTree s_tree;
+    s_tree.build_tree_fromXmlFile(str_name.c_str());
+    int ret = s_tree.add_batch_fromXmlFile(str_val.c_str());
+    printf("%u batches, ret %d\n", (unsigned)n_batch, ret);
+
+    const size_t n_itemCall = 5;
+    double d_mapSum = 0, d_fnSum = 0;
+    Bench_Clock_t::time_point t_begin = Bench_Clock_t::now();
+    for(size_t m = 0; m < n_itemCall; m++)
+    {
+      std::map<uint32_t, Tree_Val_t*> m_item;
+      s_tree.get_oneItemValue("height", m_item);
+      for(auto iter = m_item.begin(); iter != m_item.end(); ++iter)
+      {
+        d_mapSum += iter->second->u_val.val_double;
+      }
+      free_itemMap(m_item);
+    }
+    double d_map = get_ms(t_begin) / n_itemCall;
+
+    xmlTree::Tree_Handle_t h_height = s_tree.get_itemHandle("height");
+    t_begin = Bench_Clock_t::now();
+    for(size_t m = 0; m < n_itemCall; m++)
+    {
+      s_tree.for_each_in_item(h_height, [&](uint32_t batch_index, const Tree_ValView_t &s_val){
+        d_fnSum += s_val.u_val.val_double;
+      });
+    }
+    double d_fn = get_ms(t_begin) / n_itemCall;
+    printf("sum of height, get_oneItemValue: %9.2f ms, for_each_in_item:  %9.2f ms, same sum: %s\n", d_map, d_fn,
+           (fabs(d_mapSum - d_fnSum) < 1e-6 * fabs(d_mapSum)) ? "yes" : "no");
+
+    d_mapSum = d_fnSum = 0;
+    t_begin = Bench_Clock_t::now();
+    for(uint32_t m = 1; m <= n_batch; m++)
+    {
+      std::map<std::string, Tree_Val_t*> m_batch;
+      s_tree.get_oneBatchValue(m, m_batch);
+      for(auto iter = m_batch.begin(); iter != m_batch.end(); ++iter)
+      {
+        if(iter->second->e_type == VAL_Int) d_mapSum += iter->second->u_val.val_int;
+        if(iter->second->e_type == VAL_Double) d_mapSum += iter->second->u_val.val_double;
+      }
+      free_batchMap(m_batch);
+    }
+    d_map = get_ms(t_begin);
+
+    t_begin = Bench_Clock_t::now();
+    for(uint32_t m = 1; m <= n_batch; m++)
+    {
+      s_tree.for_each_in_batch(m, [&](xmlTree::Tree_Handle_t h_item, const Tree_ValView_t &s_val){
+        if(s_val.e_type == VAL_Int) d_fnSum += s_val.u_val.val_int;
+        if(s_val.e_type == VAL_Double) d_fnSum += s_val.u_val.val_double;
+      });
+    }
+    d_fn = get_ms(t_begin);
+    printf("sum of batches, get_oneBatchValue: %9.2f ms, for_each_in_batch: %9.2f ms, same sum: %s\n", d_map, d_fn,
+           (fabs(d_mapSum - d_fnSum) < 1e-6 * fabs(d_mapSum)) ? "yes" : "no");
+    return ret;
+  }
+
+  /**
+   * @brief Walk the item table of 229 items (64 with values) by the whole
+   *        tree operations which loop over it: for_each_in_batch() on each
+   *        of n_batch batches, optimize(), and deleting all batches at once.
+   */
+  int run_walk(size_t n_batch)
+  {
+    std::string str_name = make_names(14);
+    std::string str_val = make_values(n_batch, 1, 60);
+
+    xmlTree s_tree;
+    s_tree.build_tree_fromXmlFile(str_name.c_str());
+    int ret = s_tree.add_batch_fromXmlFile(str_val.c_str());
+    size_t n_valNum = 0;
+    Bench_Clock_t::time_point t_begin = Bench_Clock_t::now();
+    for(uint32_t m = 1; m <= n_batch; m++)
+    {
+      s_tree.for_each_in_batch(m, [&](xmlTree::Tree_Handle_t h_item, const Tree_ValView_t &s_val){
+        n_valNum++;
+      });
+    }
+    double d_batch = get_ms(t_begin);
+
+    t_begin = Bench_Clock_t::now();
+    s_tree.optimize();
+    double d_optimize = get_ms(t_begin);
+
+    t_begin = Bench_Clock_t::now();
+    ret |= s_tree.delete_batches(1, (uint32_t)n_batch);
+    double d_delete = get_ms(t_begin);
+    std::set<uint32_t> set_batch;
+    s_tree.get_batchSet(set_batch);
+
+    printf("%u batches, ret %d, %u values, %u batches left\n", (unsigned)n_batch, ret, (unsigned)n_valNum, (unsigned)set_batch.size());
+    printf("for_each_in_batch:  %9.1f ms, %6.2f us/batch, %6.2f ns/value\n", d_batch, d_batch * 1000 / n_batch, d_batch * 1e6 / n_valNum);
+    printf("optimize:           %9.1f ms, %6.2f ns/value\n", d_optimize, d_optimize * 1e6 / n_valNum);
+    printf("delete all batches: %9.1f ms, %6.2f ns/value\n", d_delete, d_delete * 1e6 / n_valNum);
+    return ret;
+  }
+
+  /**
+   * @brief Parse about n_number numeric members: load a value file of
+   *        n_number / 3 batches (3 numbers each) and the same file without
+   *        the numbers, the difference is what the numbers cost in load.
+   *        Then parse the texts alone, the old way by a std::string
+   *        temporary and strtol() or strtod(), by them on the text, and by
+   *        parse_intVal() or parse_doubleVal() the tree uses.
+   */
+  int run_parse(size_t n_number)
+  {
+    size_t n_batch = (n_number + 2) / 3;
+    std::string str_name = make_names(0);
+    std::string str_val = make_values(n_batch);
+    std::string str_noNumber = "bench_nonumber.xml";
+
+    std::vector<std::pair<bool, std::string> > v_number; // Is int, and text of numeric members.
+    FILE *p_in = fopen(str_val.c_str(), "rb");
+    FILE *p_out = fopen(str_noNumber.c_str(), "wb");
+    if((p_in == NULL) || (p_out == NULL)) return ERR_OpenFile;
+    char str_line[256];
+    while(fgets(str_line, sizeof(str_line), p_in) != NULL)
+    {
+      char str_type[16], str_text[64];
+      if((sscanf(str_line, "<Member name=\"%*[^\"]\" type=\"%15[^\"]\">%63[^<]", str_type, str_text) == 2) && strcmp(str_type, "string"))
+      {
+        v_number.push_back(std::make_pair(!strcmp(str_type, "int"), std::string(str_text)));
+      }
+      else
+      {
+        fputs(str_line, p_out);
+      }
+    }
+    fclose(p_in);
+    fclose(p_out);
+
+    int ret = ERR_None;
+    double arr_ms[2];
+    const char *arr_file[2] = {str_val.c_str(), str_noNumber.c_str()};
+    for(int m = 0; m < 2; m++)
+    {
+      arr_ms[m] = 0;
+      for(int n = 0; n < 3; n++) // best of 3.
+      {
+        xmlTree s_tree;
+        s_tree.build_tree_fromXmlFile(str_name.c_str());
+        Bench_Clock_t::time_point t_begin = Bench_Clock_t::now();
+        ret |= s_tree.add_batch_fromXmlFile(arr_file[m]);
+        double d_ms = get_ms(t_begin);
+        if((n == 0) || (d_ms < arr_ms[m])) arr_ms[m] = d_ms;
+      }
+    }
+    remove(str_noNumber.c_str());
+
+    double d_oldSum = 0, d_textSum = 0, d_treeSum = 0;
+    Bench_Clock_t::time_point t_begin = Bench_Clock_t::now();
+    for(size_t m = 0; m < v_number.size(); m++)
+    {
+      std::string str_temp(v_number[m].second.c_str()); // the old _set_memberVal() made one per member.
+      d_oldSum += v_number[m].first ? (double)strtol(str_temp.c_str(), NULL, 10) : strtod(str_temp.c_str(), NULL);
+    }
+    double d_old = get_ms(t_begin);
+
+    t_begin = Bench_Clock_t::now();
+    for(size_t m = 0; m < v_number.size(); m++)
+    {
+      const char *str_text = v_number[m].second.c_str();
+      d_textSum += v_number[m].first ? (double)strtol(str_text, NULL, 10) : strtod(str_text, NULL);
+    }
+    double d_text = get_ms(t_begin);
+
+    t_begin = Bench_Clock_t::now();
+    for(size_t m = 0; m < v_number.size(); m++)
+    {
+      const std::string &str_text = v_number[m].second;
+      int n_val = 0;
+      double d_val = 0;
+      if(v_number[m].first)
+      {
+        parse_intVal(str_text.c_str(), str_text.size(), n_val);
+        d_treeSum += n_val;
+      }
+      else
+      {
+        parse_doubleVal(str_text.c_str(), str_text.size(), d_val);
+        d_treeSum += d_val;
+      }
+    }
+    double d_tree = get_ms(t_begin);
+
+    size_t n_numNum = v_number.size();
+    printf("%u batches, %u numeric members, ret %d, same sums: %s\n", (unsigned)n_batch, (unsigned)n_numNum, ret,
+           ((d_oldSum == d_textSum) && (d_textSum == d_treeSum)) ? "yes" : "no");
+    printf("load with numbers:    %9.1f ms\n", arr_ms[0]);
+    printf("load without numbers: %9.1f ms\n", arr_ms[1]);
+    printf("numbers in load:      %9.1f ms, %6.1f ns/number (xml, parse and dictionary)\n", arr_ms[0] - arr_ms[1], (arr_ms[0] - arr_ms[1]) * 1e6 / n_numNum);
+    printf("std::string + strto*: %9.1f ms, %6.1f ns/number (parse only)\n", d_old, d_old * 1e6 / n_numNum);
+    printf("strto* on text:       %9.1f ms, %6.1f ns/number (parse only)\n", d_text, d_text * 1e6 / n_numNum);
+    printf("parse_*Val on text:   %9.1f ms, %6.1f ns/number (parse only)\n", d_tree, d_tree * 1e6 / n_numNum);
+    return ret;
+  }
+
+  struct Bench_Case_t
+  {
+    const char *str_name;             // Name to run the case.
+    const char *str_desc;             // What it measures.
+    size_t n_default;                 // Default size.
+    int (*fn_run)(size_t n_size);     // Function of case.
+  };
+
+  const Bench_Case_t arr_case[] =
+  {
+    {"load", "load time as batches grow (per-item value dictionary)", 200000, run_load},
+    {"names", "name lookups, recursive search vs name index", 1000000, run_names},
+    {"snapshot", "load from snapshot vs build and xml ingest", 200000, run_snapshot},
+    {"arena", "allocations and peak RSS, old-style members vs arena", 1000000, run_arena},
+    {"range", "selective and wide range queries vs scan", 200000, run_range},
+    {"groupby", "average per group, group_byItem vs get_oneBatchValue loop", 1000000, run_groupby},
+    {"shared", "reader latency of xmlSharedTree with a writer", 20000, run_shared},
+    {"delete", "delete 10% of batches, at once vs one by one", 200000, run_delete},
+    {"views", "time and allocations, copied values vs views", 200000, run_views},
+    {"foreach", "sums by callbacks vs by maps of copied values", 200000, run_foreach},
+    {"walk", "whole-tree walks over the item table", 20000, run_walk},
+    {"parse", "cost of numeric members in load, parsers vs strtod", 1000000, run_parse},
+  };
+}
+
+int main(int argc, char **argv)
+{
+  size_t n_caseNum = sizeof(bench::arr_case) / sizeof(bench::arr_case[0]);
+  if(argc < 2)
+  {
+    printf("usage: bench <case> [size]\n");
+    for(size_t m = 0; m < n_caseNum; m++)
+    {
+      printf("  %-10s %-9u %s\n", bench::arr_case[m].str_name, (unsigned)bench::arr_case[m].n_default, bench::arr_case[m].str_desc);
+    }
+    return 0;
+  }
+  for(size_t m = 0; m < n_caseNum; m++)
+  {
+    if(!strcmp(argv[1], bench::arr_case[m].str_name))
+    {
+      size_t n_size = (argc > 2) ? strtoul(argv[2], NULL, 10) : bench::arr_case[m].n_default;
+      return bench::arr_case[m].fn_run(n_size);
+    }
+  }
+  printf("unknown case: %s\n", argv[1]);
+  return 1;
+}
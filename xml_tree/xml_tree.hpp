@@ -7,7 +7,27 @@
 #include <map>
 #include <set>
 #include <list>
+#include <unordered_map>
 #include <algorithm>
+#include <new>
+#include <limits>
+#include <deque>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <utility>
+#if defined(_WIN32)
+  #include <windows.h>
+#else
+  #include <fcntl.h>
+  #include <unistd.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+#endif
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+  #define TREE_SIMD_X86                   // scan kernels of Tree_Column_t use SSE2 and AVX2.
+  #include <immintrin.h>
+#endif
 #include "rapidxml/rapidxml.hpp"
 #include "rapidxml/rapidxml_utils.hpp"
 #include "rapidxml/rapidxml_print.hpp"
@@ -15,14 +35,17 @@
 
 
 /**
- * @note  set EN_LogMsg to 1 log message, set 0 otherwise.
+ * @note  set EN_LogMsg to 1 log message, set 0 otherwise, define it before
+ *        including to change.
  */
-#define EN_LogMsg                         1u
+#ifndef EN_LogMsg
+  #define EN_LogMsg                       1u
+#endif
 
 #if EN_LogMsg > 0u
   #define  __logMsg(...) printf(__VA_ARGS__)
 #else
-  #define  __logMsg(...) (void *)0
+  #define  __logMsg(...) ((void)0)
 #endif
 
 #define  __logVal(val) \
@@ -85,6 +108,11 @@ namespace xml_tree
     ERR_UsedIndex,
     ERR_UnregisteredIndex,
     ERR_UnregisteredItem,
+    ERR_OpenFile,
+    ERR_IllegalFile,
+    ERR_UsedTree,
+    ERR_IllegalQuery,
+    ERR_IllegalValue,
   };
 
   /**
@@ -155,7 +183,7 @@ namespace xml_tree
         switch(this->e_type)
         {
         case VAL_String:
-          return !memcmp(this->u_val.val_string, val.u_val.val_string, val.n_memLen);
+          return (this->n_memLen == val.n_memLen) && !memcmp(this->u_val.val_string, val.u_val.val_string, val.n_memLen);
           break;
         case VAL_Int:
           return this->u_val.val_int == val.u_val.val_int;
@@ -175,595 +203,5572 @@ namespace xml_tree
   };
 
   /**
-   * @brief A class to build and access the xml tree.
+   * @note  Operators of predicate on value of item.
+   */
+  enum Tree_Pred_e
+  {
+    PRED_Equal = 0,                   // val == s_val.
+    PRED_NotEqual,                    // val != s_val.
+    PRED_Less,                        // val < s_val.
+    PRED_LessEqual,                   // val <= s_val.
+    PRED_Greater,                     // val > s_val.
+    PRED_GreaterEqual,                // val >= s_val.
+    PRED_Between,                     // s_val <= val <= s_valHigh.
+    PRED_Prefix,                      // string val starts with string s_val.
+  };
+
+  /**
+   * @brief Struct of predicate on value of item, used to query items.
    *
-   * @note  (1) How to use this class:
-   *            1. Use build_tree_fromXmlFile() to build the tree from
-   *               "xml_name.xml".
-   *            2. Use add_batch_fromXmlFile() to set batches of value
-   *               to items in tree from "xml_val.xml".
-   *            3. Then a tree with user value is built, use other function
-   *               to operate the user value.
+   * @note  (1) int and double are compared by number, string is compared
+   *            by bytes, a value never matches an operand of the other
+   *            kind (not even by PRED_NotEqual).
    *
-   *        (2) Since the tree item's id is type uint32_t, where one layer
-   *            needs 4 bit to set the index from 1~15, so the max number of
-   *            child items of each item is 15, the max number of layer of
-   *            tree is 8.
+   *        (2) Strings of operand are not copied, use make_stringVal().
+   */
+  struct Tree_Pred_t
+  {
+    Tree_Pred_e e_op;                 // Operator of predicate.
+    Tree_Val_t s_val;                 // Operand, or low bound of PRED_Between.
+    Tree_Val_t s_valHigh;             // High bound of PRED_Between.
+  };
+
+  inline Tree_Val_t make_intVal(int n_val)
+  {
+    Tree_Val_t s_val;
+    s_val.e_type = VAL_Int;
+    s_val.u_val.val_int = n_val;
+    s_val.n_memLen = 0;
+    return s_val;
+  }
+
+  inline Tree_Val_t make_doubleVal(double d_val)
+  {
+    Tree_Val_t s_val;
+    s_val.e_type = VAL_Double;
+    s_val.u_val.val_double = d_val;
+    s_val.n_memLen = 0;
+    return s_val;
+  }
+
+  /**
+   * @note  functions to make operand of predicate. A string value points
+   *        to str_val, it does not copy the string.
+   */
+  inline Tree_Val_t make_stringVal(const char* str_val)
+  {
+    Tree_Val_t s_val;
+    s_val.e_type = VAL_String;
+    s_val.u_val.val_string = const_cast<char *>(str_val);
+    s_val.n_memLen = static_cast<int>(strlen(str_val)) + 1;
+    return s_val;
+  }
+
+  /**
+   * @note  the operand is copied by member (not by operator =), so the
+   *        string is not copied either.
+   */
+  inline Tree_Pred_t make_pred(Tree_Pred_e e_op, const Tree_Val_t &s_val)
+  {
+    Tree_Pred_t s_pred = {e_op, s_val, s_val};
+    return s_pred;
+  }
+
+  inline Tree_Pred_t make_betweenPred(const Tree_Val_t &s_valLow, const Tree_Val_t &s_valHigh)
+  {
+    Tree_Pred_t s_pred = {PRED_Between, s_valLow, s_valHigh};
+    return s_pred;
+  }
+
+  inline bool is_blank(char c_char)
+  {
+    return (c_char == ' ') || (c_char == '\t') || (c_char == '\r') || (c_char == '\n') || (c_char == '\v') || (c_char == '\f');
+  }
+
+  /**
+   * @brief This func drop the blanks around [p_begin, p_end), which
+   *        strtol() and strtod() skip too.
+   */
+  inline void trim_blank(const char *&p_begin, const char *&p_end)
+  {
+    while((p_begin != p_end) && is_blank(*p_begin)) p_begin++;
+    while((p_begin != p_end) && is_blank(*(p_end - 1))) p_end--;
+  }
+
+  /**
+   * @brief This func parse a decimal int like strtol(), but the whole
+   *        text must be the number.
    *
-   *        (3) Also look "xml_name.xml" and "xml_val.xml" to know more
-   *            well about how to use.
+   * @ret   return false if it is not a number or out of range of int.
    */
-  class xmlTree
+  inline bool parse_intVal(const char *str_val, size_t n_len, int &n_val)
   {
-  public:
-#define FORMAT_Item_Id         16                 // item id use hex format.
-#define FORMAT_Batch_Index     10                 // batch index use 10 format.
+    const char *p_cur = str_val, *p_end = str_val + n_len;
+    trim_blank(p_cur, p_end);
+    bool is_neg = false;
+    if((p_cur != p_end) && ((*p_cur == '-') || (*p_cur == '+')))
+    {
+      is_neg = (*p_cur == '-');
+      p_cur++;
+    }
+    if(p_cur == p_end) return false;
 
-    xmlTree()
+    uint64_t n_abs = 0;
+    const uint64_t n_limit = is_neg ? 2147483648u : 2147483647u;
+    for( ; p_cur != p_end; p_cur++)
     {
-      s_rootItem.n_id = 0;
+      if((*p_cur < '0') || (*p_cur > '9')) return false;
+      n_abs = n_abs * 10 + (*p_cur - '0');
+      if(n_abs > n_limit) return false;
     }
+    n_val = is_neg ? static_cast<int>(-static_cast<int64_t>(n_abs)) : static_cast<int>(n_abs);
+    return true;
+  }
 
-    ~xmlTree()
+  /**
+   * @brief This func parse a double like strtod(), but the whole text must
+   *        be the number.
+   *
+   * @note  (1) Plain decimals with at most 19 digits are parsed directly,
+   *            the result is exact when the digits fit in 53 bits and the
+   *            power of 10 is within 22, both are exact doubles.
+   *
+   *        (2) Others (long, inf, nan, hex) are copied to a buffer on
+   *            stack and parsed by strtod().
+   *
+   * @ret   return false if it is not a number.
+   */
+  inline bool parse_doubleVal(const char *str_val, size_t n_len, double &d_val)
+  {
+    static const double arr_pow10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                       1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+    const char *p_cur = str_val, *p_end = str_val + n_len;
+    trim_blank(p_cur, p_end);
+    const char *p_begin = p_cur;
+
+    bool is_neg = false;
+    if((p_cur != p_end) && ((*p_cur == '-') || (*p_cur == '+')))
     {
-      _free_itemTree(&s_rootItem);
-      __logMsg("xml tree free succ\r\n.");
+      is_neg = (*p_cur == '-');
+      p_cur++;
+    }
+    uint64_t n_mant = 0;
+    int n_digit = 0, n_exp = 0;
+    bool has_digit = false;
+    for( ; (p_cur != p_end) && (*p_cur >= '0') && (*p_cur <= '9'); p_cur++)
+    {
+      n_mant = n_mant * 10 + (*p_cur - '0');
+      n_digit += (n_mant != 0); // leading zeros are not counted.
+      has_digit = true;
+      if(n_digit > 19) break;
+    }
+    if((p_cur != p_end) && (*p_cur == '.') && (n_digit <= 19))
+    {
+      for(p_cur++; (p_cur != p_end) && (*p_cur >= '0') && (*p_cur <= '9'); p_cur++)
+      {
+        n_mant = n_mant * 10 + (*p_cur - '0');
+        n_digit += (n_mant != 0);
+        n_exp--;
+        has_digit = true;
+        if(n_digit > 19) break;
+      }
+    }
+    if(has_digit && (p_cur != p_end) && ((*p_cur == 'e') || (*p_cur == 'E')) && (n_digit <= 19))
+    {
+      const char *p_exp = p_cur + 1;
+      bool is_negExp = false;
+      if((p_exp != p_end) && ((*p_exp == '-') || (*p_exp == '+')))
+      {
+        is_negExp = (*p_exp == '-');
+        p_exp++;
+      }
+      int n_expVal = 0;
+      const char *p_expDigit = p_exp;
+      for( ; (p_exp != p_end) && (*p_exp >= '0') && (*p_exp <= '9') && (n_expVal < 10000); p_exp++)
+      {
+        n_expVal = n_expVal * 10 + (*p_exp - '0');
+      }
+      if(p_exp != p_expDigit)
+      {
+        n_exp += is_negExp ? -n_expVal : n_expVal;
+        p_cur = p_exp;
+      }
+    }
+    if(has_digit && (p_cur == p_end) && (n_digit <= 19) && (n_mant <= (1ull << 53)) && (n_exp >= -22) && (n_exp <= 22))
+    {
+      d_val = static_cast<double>(n_mant);
+      d_val = (n_exp < 0) ? d_val / arr_pow10[-n_exp] : d_val * arr_pow10[n_exp];
+      if(is_neg) d_val = -d_val;
+      return true;
     }
 
-    /**
-     * @brief This func build the tree by "xml_name.xml",which contains
-     *        the name of item and structure of tree.
-     *
-     * @input str_xml_name: name of xml file.
-	 *
-	 * @ret   return ERR_None if success otherwise return error code.
-     */
-    int build_tree_fromXmlFile(const char* str_xml_name)
+    /* slow path */
+    size_t n_numLen = p_end - p_begin;
+    if(n_numLen == 0) return false;
+    const size_t n_bufLen = 64; // numbers shorter than it are parsed on stack.
+    char arr_buf[n_bufLen];
+    std::string str_long; // only for numbers too long for the buffer.
+    char *p_buf = arr_buf;
+    if(n_numLen >= n_bufLen)
     {
-      int ret = ERR_None;
+      str_long.assign(p_begin, n_numLen);
+      p_buf = &str_long[0];
+    }
+    else
+    {
+      memcpy(arr_buf, p_begin, n_numLen);
+      arr_buf[n_numLen] = '\0';
+    }
+    char *p_char;
+    d_val = strtod(p_buf, &p_char);
+    return p_char == p_buf + n_numLen;
+  }
 
-      rapidxml::file<> xml_file(str_xml_name);
-      rapidxml::xml_document<> xml_doc;
-      xml_doc.parse<0>(xml_file.data());
+  /**
+   * @note  Operators of node of query over several items.
+   */
+  enum Tree_Query_e
+  {
+    QUERY_Pred = 0,                   // predicate on one item.
+    QUERY_And,                        // all of childs.
+    QUERY_Or,                         // any of childs.
+    QUERY_Not,                        // not the only child.
+  };
 
-      rapidxml::xml_node<>* root_node = xml_doc.first_node();
-      ret = _make_itemTree(root_node, &s_rootItem, 0);
-      if(ret == ERR_None)
+  /**
+   * @note  How an item keeps its values, see xmlTree::optimize().
+   */
+  enum Tree_Encoding_e
+  {
+    ENC_Dictionary = 0,               // members of distinct values with bitmaps of batches.
+    ENC_Dense,                        // column of numbers indexed by batch.
+    ENC_Run,                          // members with bitmaps of runs, no index of batch.
+  };
+
+  /**
+   * @brief Struct of encoding of one item and what it is chosen by, see
+   *        xmlTree::get_itemEncoding().
+   *
+   * @note  the numbers of values are measured by the last optimize(), they
+   *        are 0 before it.
+   */
+  struct Tree_Encoding_t
+  {
+    Tree_Encoding_e e_encoding;       // Encoding in use.
+    uint64_t n_batchNum;              // Number of batches with value.
+    uint64_t n_distinctNum;           // Number of distinct values.
+    uint64_t n_runNum;                // Number of runs of one value over contiguous batches.
+    size_t n_memSize;                 // Estimated bytes used by values of item now.
+  };
+
+  /**
+   * @brief Struct of statistics over the numbers of one item.
+   *
+   * @note  min, max and avg are 0 if n_count is 0.
+   */
+  struct Tree_Stat_t
+  {
+    uint64_t n_count;                 // Number of batches with a number value.
+    double d_sum;                     // Sum of values.
+    double d_min;                     // Min of values.
+    double d_max;                     // Max of values.
+    double d_avg;                     // Average of values.
+  };
+
+  /**
+   * @brief Struct of one group of group by, see xmlTree::group_byItem().
+   *
+   * @note  a string s_key points to the value kept by tree, it is valid
+   *        until the tree is changed.
+   */
+  struct Tree_Group_t
+  {
+    Tree_Val_t s_key;                 // Value of key item.
+    uint64_t n_batchNum;              // Number of batches of the key.
+    Tree_Stat_t s_stat;               // Statistics of value item over these batches.
+  };
+
+  /**
+   * @brief View of a value kept by tree, like Tree_Val_t but nothing is
+   *        allocated or copied, a string points to the one in tree.
+   *
+   * @note  a view is valid until the tree is changed or destroyed, copy
+   *        it by make_val() to keep it longer.
+   */
+  struct Tree_ValView_t
+  {
+    Tree_Val_e e_type;                // Enum of type of value.
+    union
+    {
+      int val_int;
+      double val_double;
+      const char* val_string;         // String ends with '\0'.
+    } u_val;                          // Union of value.
+    size_t n_len;                     // Length of string without '\0', 0 for numbers.
+
+    static Tree_ValView_t make_view(const Tree_Val_t &s_val)
+    {
+      Tree_ValView_t s_view;
+      s_view.e_type = s_val.e_type;
+      s_view.n_len = 0;
+      switch(s_val.e_type)
       {
-        __logMsg("\r\n xml tree build succ.\r\n");
+      case VAL_String:
+        s_view.u_val.val_string = s_val.u_val.val_string;
+        s_view.n_len = s_val.n_memLen - 1;
+        break;
+      case VAL_Int:
+        s_view.u_val.val_int = s_val.u_val.val_int;
+        break;
+      case VAL_Double:
+        s_view.u_val.val_double = s_val.u_val.val_double;
+        break;
+      default:
+        s_view.u_val.val_string = NULL;
+        break;
       }
-      else
+      return s_view;
+    }
+
+    /* copy to a Tree_Val_t, the string is allocated like Tree_Val_t::operator =. */
+    Tree_Val_t make_val() const
+    {
+      Tree_Val_t s_val;
+      s_val.e_type = e_type;
+      s_val.n_memLen = 0;
+      switch(e_type)
       {
-        __logMsg("\r\n xml tree build fail, err code: %d\r\n", ret);
+      case VAL_String:
+        s_val.n_memLen = static_cast<int>(n_len) + 1;
+        s_val.u_val.val_string = new char[n_len + 1];
+        memcpy(s_val.u_val.val_string, u_val.val_string, n_len + 1);
+        break;
+      case VAL_Int:
+        s_val.u_val.val_int = u_val.val_int;
+        break;
+      case VAL_Double:
+        s_val.u_val.val_double = u_val.val_double;
+        break;
+      default:
+        s_val.u_val.val_string = NULL;
+        break;
       }
+      return s_val;
+    }
+  };
 
-      return ret;
+  /**
+   * @note  Value of one item in one batch, see xmlTree::get_oneItemView().
+   */
+  struct Tree_BatchView_t
+  {
+    uint32_t n_batchIndex;            // Index of batch.
+    Tree_ValView_t s_val;             // Value of item in this batch.
+  };
+
+  /**
+   * @brief A class to map a file into memory, so the xml file can be
+   *        parsed in place instead of being copied into a buffer.
+   *
+   * @note  (1) The file is mapped copy-on-write, rapidxml's writes (the
+   *            terminators of names and values) go to private pages and
+   *            never reach the file.
+   *
+   *        (2) The data is always followed by a '\0', as rapidxml needs.
+   *            If the system can not promise that, the file is read into
+   *            a buffer instead.
+   */
+  class Tree_FileMap_t
+  {
+  public:
+    Tree_FileMap_t() : p_data(NULL), n_size(0), is_mapped(false) {}
+
+    ~Tree_FileMap_t()
+    {
+      unmap_file();
     }
 
     /**
-     * @brief This func set batches of value of item by an xml file,
-     *        which stores batches of value in parallel mode.
-     *
-     * @input str_xml_val: name of value xml file.
-	 *
-	 * @ret   return ERR_None if success otherwise return error code.
+     * @ret return true if the file is mapped (or read), false otherwise.
      */
-    int add_batch_fromXmlFile(const char* str_xml_val)
+    bool map_file(const char* str_file)
     {
-      int ret = ERR_None;
-
-      rapidxml::file<> xml_file(str_xml_val);
-      rapidxml::xml_document<> xml_doc;
-      xml_doc.parse<0>(xml_file.data());
+      unmap_file();
+#if defined(_WIN32)
+      HANDLE h_file = CreateFileA(str_file, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+      if(h_file == INVALID_HANDLE_VALUE) return false;
 
-      rapidxml::xml_node<>* root_node = xml_doc.first_node();
-      /* use a loop to get all bathes of value in xml file. */
-      rapidxml::xml_node<>* batch_node = root_node->first_node(C_strBatchTag.c_str());
-      for( ; batch_node != NULL; batch_node = batch_node->next_sibling(C_strBatchTag.c_str()))
+      LARGE_INTEGER n_fileSize;
+      SYSTEM_INFO s_sysInfo;
+      GetSystemInfo(&s_sysInfo);
+      if(GetFileSizeEx(h_file, &n_fileSize))
       {
-        uint32_t batch_index = _get_batchIndex(batch_node);
-        __logMsg("\r\nadding batch %d\r\n", batch_index);
-        if(ret = _push_memberVector(batch_node->first_node(), batch_index) != ERR_None)
+        n_size = static_cast<size_t>(n_fileSize.QuadPart);
+        if((n_size % s_sysInfo.dwPageSize) != 0) // the tail of last page is zero filled.
         {
-          break; // exit the loop if operation is illegal.
+          HANDLE h_map = CreateFileMappingA(h_file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+          if(h_map != NULL)
+          {
+            p_data = static_cast<char *>(MapViewOfFile(h_map, FILE_MAP_COPY, 0, 0, 0));
+            is_mapped = (p_data != NULL);
+            CloseHandle(h_map);
+          }
+        }
+        if(!is_mapped) // read the file into a buffer instead.
+        {
+          DWORD n_read = 0;
+          p_data = new char[n_size + 1];
+          if(!ReadFile(h_file, p_data, static_cast<DWORD>(n_size), &n_read, NULL) || (n_read != n_size))
+          {
+            delete[] p_data;
+            p_data = NULL;
+          }
+          else
+          {
+            p_data[n_size] = '\0';
+          }
         }
-        set_batchIndex.insert(batch_index); // insert to batch index set for record usage.
-      }
-      if(ret == 0)
-      {
-        __logMsg("\r\n xml tree set value succ.\r\n");
       }
-      else
+      CloseHandle(h_file);
+#else
+      int n_fd = ::open(str_file, O_RDONLY);
+      if(n_fd < 0) return false;
+
+      struct stat s_stat;
+      if(fstat(n_fd, &s_stat) == 0)
       {
-        __logMsg("\r\n xml tree set value failed, err code: %d\r\n", ret);
+        n_size = static_cast<size_t>(s_stat.st_size);
+        /* reserve one more byte of zero page behind the file, then map the file over it. */
+        void *p_base = mmap(NULL, n_size + 1, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if(p_base != MAP_FAILED)
+        {
+          is_mapped = true;
+          p_data = static_cast<char *>(p_base);
+          if((n_size > 0) && (mmap(p_base, n_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, n_fd, 0) == MAP_FAILED))
+          {
+            unmap_file();
+          }
+        }
       }
-
-      return ret;
+      ::close(n_fd);
+#endif
+      return (p_data != NULL);
     }
 
-    /**
-     * @brief This func get the name of one item.
-     *
-     * @input n_itemId: id of item, look "xml_name.xml" for its combination.
-	 *
-	 * @ret   return name of item.
-     */
-    const char* get_itemName(uint32_t n_itemId)
+    void unmap_file()
     {
-      Tree_Item_t *item = _search_item_byId(n_itemId);
-      if(item != NULL)
+      if(p_data != NULL)
       {
-        if(!item->str_name.empty())
+#if defined(_WIN32)
+        if(is_mapped)
         {
-          return item->str_name.c_str();
+          UnmapViewOfFile(p_data);
+        }
+        else
+        {
+          delete[] p_data;
         }
+#else
+        munmap(p_data, n_size + 1);
+#endif
       }
-      return NULL;
+      p_data = NULL;
+      n_size = 0;
+      is_mapped = false;
+    }
+
+    char* data() const
+    {
+      return p_data;
+    }
+
+    size_t size() const
+    {
+      return n_size;
     }
 
+  private:
     /**
-     * @brief This func return the set of batch index.
-     *
-     * @note  (1) User can check this set with the batch index
-     *            in "xml_val.xml", they should be the same.
+     * @note no copying!
      */
-    void get_batchSet(std::set<uint32_t> &set_batch) const
+    Tree_FileMap_t(const Tree_FileMap_t &);
+    void operator =(const Tree_FileMap_t &);
+
+    char *p_data;                     // Data of file, followed by '\0'.
+    size_t n_size;                    // Size of file.
+    bool is_mapped;                   // Data is mapped, or read into buffer.
+  };
+
+  /**
+   * @brief An arena for the memory of members of tree, so allocation is
+   *        a pointer bump in rapidxml::memory_pool, and all memory is freed
+   *        at once with the chunks of pool.
+   *
+   * @note  (1) Freed blocks are kept in free lists by size and reused,
+   *            so deleting batches does not make the arena grow.
+   *
+   *        (2) After set_releasing(), deallocate() does nothing, the owner
+   *            can skip destroying objects in the arena one by one.
+   */
+  class Tree_Arena_t
+  {
+  public:
+    Tree_Arena_t() : is_releasing(false)
     {
-      set_batch.clear(); // clear the original element first.
-      for(auto iter = set_batchIndex.rbegin(); iter != set_batchIndex.rend(); ++iter)
-      {
-        set_batch.insert((*iter)); // copy from set_batchIndex.
-      }
+      memset(arr_freeBlock, 0, sizeof(arr_freeBlock));
     }
 
+    void* allocate(size_t n_size)
+    {
+      n_size = _round_size(n_size);
+      void *&p_free = _get_freeList(n_size);
+      if(p_free != NULL) // reuse a freed block.
+      {
+        void *p_block = p_free;
+        p_free = *static_cast<void **>(p_block);
+        return p_block;
+      }
+      return s_pool.allocate_string(0, n_size);
+    }
+
+    void deallocate(void* p_block, size_t n_size)
+    {
+      if((p_block != NULL) && !is_releasing)
+      {
+        void *&p_free = _get_freeList(_round_size(n_size));
+        *static_cast<void **>(p_block) = p_free; // link the block into free list.
+        p_free = p_block;
+      }
+    }
+
+    char* allocate_string(const char* str_src, size_t n_len)
+    {
+      char *str_dst = static_cast<char *>(allocate(n_len));
+      memcpy(str_dst, str_src, n_len);
+      return str_dst;
+    }
+
+    void set_releasing()
+    {
+      is_releasing = true;
+    }
+
+    bool get_releasing() const
+    {
+      return is_releasing;
+    }
+
+  private:
     /**
-     * @brief This func get one batch of value by its index.
-     *
-     * @input n_batchIndex: index of batch.
-     * @output m_batch: map of pair <name, val>.
-	 *
-	 * @ret   return ERR_None if suceess otherwise return error code.
-     *
-     * @note  (1) the val element in m_batch is allocate in this function,
-     *            so remember to free space of it before clear the map.
-     *            The way to free:
-     *            {
-     *              if(val->e_type == VAL_String) delete val->u_val.val_string;
-     *              delete val;
-     *            }
+     * @note no copying!
      */
-    int get_oneBatchValue(uint32_t n_batchIndex, std::map<std::string, Tree_Val_t*> &m_batch) const
+    Tree_Arena_t(const Tree_Arena_t &);
+    void operator =(const Tree_Arena_t &);
+
+    size_t _round_size(size_t n_size) const
+    {
+      return (n_size + sizeof(void *) - 1) / sizeof(void *) * sizeof(void *); // a freed block must hold a pointer.
+    }
+
+    void*& _get_freeList(size_t n_size)
     {
-      auto iter = set_batchIndex.find(n_batchIndex);
-      if(iter != set_batchIndex.end())
+      size_t n_slot = n_size / sizeof(void *);
+      if(n_slot < C_nSmallSlot)
       {
-        _get_membersOfBatch(&s_rootItem, n_batchIndex, m_batch);
-        return ERR_None;
+        return arr_freeBlock[n_slot];
       }
-      return ERR_UnregisteredIndex;
+      return m_freeBlock[n_size]; // large block, like bucket array of hash map.
+    }
+
+    static const size_t C_nSmallSlot = 64;
+
+    rapidxml::memory_pool<char> s_pool;       // Pool that the chunks come from.
+    void *arr_freeBlock[C_nSmallSlot];        // Free lists of small blocks, by size in pointer.
+    std::map<size_t, void *> m_freeBlock;     // Free lists of large blocks, by size.
+    bool is_releasing;                        // The whole arena is being freed.
+  };
+
+  /**
+   * @brief STL allocator on Tree_Arena_t, for containers in the tree.
+   */
+  template<class T>
+  struct Tree_PoolAlloc_t
+  {
+    typedef T value_type;
+
+    Tree_PoolAlloc_t(Tree_Arena_t *arena) : p_arena(arena) {}
+
+    template<class U>
+    Tree_PoolAlloc_t(const Tree_PoolAlloc_t<U> &alloc) : p_arena(alloc.p_arena) {}
+
+    T* allocate(size_t n_num)
+    {
+      return static_cast<T *>(p_arena->allocate(n_num * sizeof(T)));
+    }
+
+    void deallocate(T* p_block, size_t n_num)
+    {
+      p_arena->deallocate(p_block, n_num * sizeof(T));
+    }
+
+    template<class U>
+    bool operator ==(const Tree_PoolAlloc_t<U> &alloc) const
+    {
+      return p_arena == alloc.p_arena;
+    }
+
+    template<class U>
+    bool operator !=(const Tree_PoolAlloc_t<U> &alloc) const
+    {
+      return p_arena != alloc.p_arena;
+    }
+
+    Tree_Arena_t *p_arena;
+  };
+
+  /**
+   * @brief A pool of the strings of values in tree, each distinct string is
+   *        kept once with a stable 32-bit id, its length and hash.
+   *
+   * @note  (1) Strings are found in an open addressing table of ids, where
+   *            the saved hashes are compared before the strings, and the
+   *            table grows without hashing the strings again.
+   *
+   *        (2) A string is counted by the members using it, it is freed and
+   *            its id is reused after the last one releases it.
+   *
+   *        (3) A borrowed string lives as long as the tree (text of value
+   *            file or mapped snapshot), so it is not copied.
+   */
+  class Tree_StrPool_t
+  {
+  public:
+    Tree_StrPool_t(Tree_Arena_t *arena) : p_arena(arena), n_strNum(0) {}
+
+    ~Tree_StrPool_t()
+    {
+      clear();
     }
 
     /**
-     * @brief This func get value of once item by its item id.
-     *
-     * @input n_itemId: id of item.
-     * @output m_item: map of pair <batch_index, val>.
+     * @ret return id of string, C_nNoStr if it is not in pool.
+     */
+    uint32_t find(const char *str_val, size_t n_memLen) const
+    {
+      if(v_slot.empty()) return C_nNoStr;
+      return v_slot[_find_slot(str_val, n_memLen, _hash(str_val, n_memLen))];
+    }
+
+    /**
+     * @brief This func add a reference to string, it is copied into pool
+     *        if new, unless it is borrowed.
      *
-     * @ret return return ERR_None if success otherwise return error code.
+     * @input n_memLen: length of string with the ending '\0'.
      *
-     * @note  (1) the val element in m_batch is allocate in this function,
-     *            so remember to free space of it before clear the map.
-     *            The way to free:
-     *            {
-     *              if(val->e_type == VAL_String) delete val->u_val.val_string;
-     *              delete val;
-     *            }
+     * @ret   return id of string.
      */
-    int get_oneItemValue(const char* str_itemName, std::map<uint32_t, Tree_Val_t*> &m_item)
+    uint32_t intern(const char *str_val, size_t n_memLen, bool is_borrowed)
     {
-      Tree_Item_t *item = _search_item_byName(&s_rootItem, str_itemName);
-      if(item != NULL)
+      if((n_strNum + 1) * 4 > v_slot.size() * 3) // keep load factor under 0.75.
       {
-        _get_membersOfItem(item, m_item);
-        return ERR_None;
+        _grow();
       }
-      return ERR_UnregisteredItem;
+      uint32_t n_hash = _hash(str_val, n_memLen);
+      size_t n_slot = _find_slot(str_val, n_memLen, n_hash);
+      if(v_slot[n_slot] == C_nNoStr)
+      {
+        uint32_t n_id;
+        if(!v_freeId.empty())
+        {
+          n_id = v_freeId.back();
+          v_freeId.pop_back();
+        }
+        else
+        {
+          n_id = static_cast<uint32_t>(v_entry.size());
+          v_entry.push_back(Tree_StrEntry_t());
+        }
+        Tree_StrEntry_t &s_entry = v_entry[n_id];
+        s_entry.p_str = is_borrowed ? str_val : p_arena->allocate_string(str_val, n_memLen);
+        s_entry.n_memLen = static_cast<uint32_t>(n_memLen);
+        s_entry.n_hash = n_hash;
+        s_entry.n_ref = 0;
+        s_entry.is_borrowed = is_borrowed;
+        v_slot[n_slot] = n_id;
+        n_strNum++;
+      }
+      v_entry[v_slot[n_slot]].n_ref++;
+      return v_slot[n_slot];
     }
 
     /**
-     * @brief This func delete one batch of value.
-     *
-     * @input n_batchIndex: index of batch.
-     *
-     * @ret   Return ERR_None if the n_batchIndex is legal,
-	 *        return error code otherwise.
+     * @brief This func drop a reference to string, the last one removes
+     *        it from pool.
      */
-     int delete_oneBatch(uint32_t n_batchIndex)
-     {
-        auto iter = set_batchIndex.find(n_batchIndex);
-        if(iter != set_batchIndex.end())
+    void release(uint32_t n_id)
+    {
+      Tree_StrEntry_t &s_entry = v_entry[n_id];
+      if(--s_entry.n_ref != 0) return;
+
+      size_t n_mask = v_slot.size() - 1;
+      size_t n_slot = s_entry.n_hash & n_mask;
+      while(v_slot[n_slot] != n_id)
+      {
+        n_slot = (n_slot + 1) & n_mask;
+      }
+      for(size_t n_next = (n_slot + 1) & n_mask; v_slot[n_next] != C_nNoStr; n_next = (n_next + 1) & n_mask)
+      {
+        size_t n_home = v_entry[v_slot[n_next]].n_hash & n_mask;
+        if(((n_next - n_home) & n_mask) >= ((n_next - n_slot) & n_mask)) // its probe passes the hole, move it back.
         {
-          _delete_membersOfBatch(&s_rootItem, n_batchIndex);
-          set_batchIndex.erase(iter);
-          return 0;
+          v_slot[n_slot] = v_slot[n_next];
+          n_slot = n_next;
         }
-        return ERR_UnregisteredIndex;
-     }
+      }
+      v_slot[n_slot] = C_nNoStr;
 
-  private:
+      if(!s_entry.is_borrowed)
+      {
+        p_arena->deallocate(const_cast<char *>(s_entry.p_str), s_entry.n_memLen);
+      }
+      s_entry.p_str = NULL;
+      v_freeId.push_back(n_id);
+      n_strNum--;
+    }
+
+    const char *get_string(uint32_t n_id) const
+    {
+      return v_entry[n_id].p_str;
+    }
+
+    uint32_t get_hash(uint32_t n_id) const
+    {
+      return v_entry[n_id].n_hash;
+    }
+
+    uint32_t get_refNum(uint32_t n_id) const
+    {
+      return v_entry[n_id].n_ref;
+    }
+
+    bool is_borrowed(uint32_t n_id) const
+    {
+      return v_entry[n_id].is_borrowed;
+    }
+
+    size_t size() const
+    {
+      return n_strNum;
+    }
+
+    void clear()
+    {
+      for(auto iter = v_entry.begin(); iter != v_entry.end(); ++iter)
+      {
+        if((iter->p_str != NULL) && !iter->is_borrowed)
+        {
+          p_arena->deallocate(const_cast<char *>(iter->p_str), iter->n_memLen);
+        }
+      }
+      std::vector<Tree_StrEntry_t>().swap(v_entry);
+      std::vector<uint32_t>().swap(v_slot);
+      std::vector<uint32_t>().swap(v_freeId);
+      n_strNum = 0;
+    }
+
+    static const uint32_t C_nNoStr = 0xffffffff;
 
+  private:
     /**
      * @note no copying!
      */
-    xmlTree(const xmlTree &);
-    void operator =(const xmlTree &);
+    Tree_StrPool_t(const Tree_StrPool_t &);
+    void operator =(const Tree_StrPool_t &);
 
-    struct Tree_Member_t
+    struct Tree_StrEntry_t
     {
-      Tree_Val_t s_val;                               // Struct of value of member.
-      std::set<uint32_t> set_batchIndex;              // Set of index of batch that this member is in.
+      const char *p_str;                  // String ends with '\0', NULL if the id is free.
+      uint32_t n_memLen;                  // Length of string with the ending '\0'.
+      uint32_t n_hash;                    // Hash of string.
+      uint32_t n_ref;                     // Number of members using it.
+      bool is_borrowed;                   // String is not copied into arena.
     };
 
-    struct Tree_Item_t
+    static uint32_t _hash(const char *str_val, size_t n_memLen)
     {
-      uint32_t n_id;                                  // id of item.
-      std::string str_name;                           // Name of item.
-
-      std::list<Tree_Member_t *> l_member;              // List of member of item.
-      std::vector<Tree_Item_t *> v_childItem;           // Vector of all childs' item.
-    };
+      uint32_t hash = 2166136261u; // FNV-1a.
+      for(size_t m = 0; m < n_memLen; m++)
+      {
+        hash = (hash ^ static_cast<unsigned char>(str_val[m])) * 16777619u;
+      }
+      return hash;
+    }
 
     /**
-     * @ret Return ERR_None if build item tree succeed, otherwise return error code.
-     *      Conditions to succeed:
-     *      (1) all sub layers return 0. (ret |= _make_itemTree())
-     *      (2) all item in this layer is legal.
-     *          ((cnt_item != 0) && (cnt_item == cnt_legalItem))
-     *      Or
-     *      (1) in last layer directly return 0.
-     *          ((node_parent->first_node() == NULL) && (n_layer > 0))
+     * @ret return the slot holding the string, or the empty slot where it
+     *      would be put.
      */
-    int _make_itemTree(const rapidxml::xml_node<>* node_parent, Tree_Item_t *item_parent, int n_layer)
+    size_t _find_slot(const char *str_val, size_t n_memLen, uint32_t n_hash) const
     {
-      int ret = ERR_NullPointer;
+      size_t n_mask = v_slot.size() - 1;
+      size_t n_slot = n_hash & n_mask;
+      for( ; v_slot[n_slot] != C_nNoStr; n_slot = (n_slot + 1) & n_mask)
+      {
+        const Tree_StrEntry_t &s_entry = v_entry[v_slot[n_slot]];
+        if((s_entry.n_hash == n_hash) && (s_entry.n_memLen == n_memLen) && !memcmp(s_entry.p_str, str_val, n_memLen))
+        {
+          break;
+        }
+      }
+      return n_slot;
+    }
 
-      if((node_parent != NULL) && (item_parent != NULL)) // node and item is not null.
+    void _grow()
+    {
+      std::vector<uint32_t> v_old(v_slot.empty() ? 16 : v_slot.size() * 2, static_cast<uint32_t>(C_nNoStr));
+      v_old.swap(v_slot);
+      size_t n_mask = v_slot.size() - 1;
+      for(auto iter = v_old.begin(); iter != v_old.end(); ++iter)
       {
-        ret = ERR_OverLayer;
-        if(n_layer < C_nMaxLayer) // the layer number can not >= C_nMaxLayer.
+        if((*iter) == C_nNoStr) continue;
+        size_t n_slot = v_entry[*iter].n_hash & n_mask; // saved hash, the string is not read.
+        while(v_slot[n_slot] != C_nNoStr)
         {
-          if((node_parent->first_node() == NULL) && (n_layer > 0)) return ERR_None; // the last layer directly return ERR_None.
+          n_slot = (n_slot + 1) & n_mask;
+        }
+        v_slot[n_slot] = (*iter);
+      }
+    }
 
-          ret = ERR_NoXmlNode;
-          int last_err = ERR_None;
-          int cnt_item = 0, cnt_legalItem = 0;
-          std::set<uint32_t> index_set;
-          rapidxml::xml_node<>* child_node = node_parent->first_node(C_strItemTag.c_str());
-          for( ; child_node != NULL; cnt_item++, child_node = child_node->next_sibling(C_strItemTag.c_str())) // should have item node.
-          {
-            if(cnt_item > C_nMaxItem) //should contain fewer than C_nMaxItem items.
-            {
-              ret = ERR_OverItem;
-              break;
-            }
-            ret = ERR_NoXmlAttr;
-            char *p_char;
-            Tree_Item_t *child_item = new Tree_Item_t;
-            rapidxml::xml_attribute<>* temp_attr = child_node->first_attribute(C_strIndexTag.c_str());
-            if(temp_attr != NULL) // should have item layer index attribute.
-            {
-              ret = ERR_IllegalIndex;
-              uint32_t item_index = static_cast<uint32_t>(strtol(temp_attr->value(), &p_char, 10));
-              if((item_index != 0) && (item_index <= C_nMaxItem) && (index_set.find(item_index) == index_set.end())) // item index is legal and not used.
-              {
-                child_item->n_id = (item_index << C_nCrorNum * n_layer) | item_parent->n_id;
-                child_item->str_name = child_node->first_attribute(C_strNameTag.c_str())->value();
-                item_parent->v_childItem.push_back(child_item); // put the item into child vector.
-                __logMsg("add item: name(%s) id(%08x)\r\n",child_item->str_name.c_str(), child_item->n_id);
+    Tree_Arena_t *p_arena;                      // Arena of copied strings.
+    std::vector<Tree_StrEntry_t> v_entry;       // Strings by id.
+    std::vector<uint32_t> v_slot;               // Open addressing table of ids, size is power of 2.
+    std::vector<uint32_t> v_freeId;             // Ids to reuse.
+    size_t n_strNum;                            // Number of strings in pool.
+  };
 
-                index_set.insert(item_index);
-                cnt_legalItem ++;
-                last_err |= _make_itemTree(child_node, child_item, n_layer+1);
-              }
-            }
-          }
-          index_set.clear();
-          if((cnt_item != 0) && (cnt_item == cnt_legalItem))
-          {
-            ret = last_err;
-          }
-          else
-          {
-            ret = ret;
-          }
+  /**
+   * @brief A compressed bitmap of uint32_t (Roaring-style), used to store
+   *        the set of batch index of members.
+   *
+   * @note  (1) Ids are split by their high 16 bits into containers, and
+   *            each container stores the low 16 bits in one of:
+   *            array  - sorted uint16_t, for no more than 4096 ids.
+   *            bitmap - 65536 bits, for more than 4096 ids.
+   *            run    - pairs of (start, length - 1) of contiguous ids.
+   *
+   *        (2) Run containers are only made by run_optimize(), changing a
+   *            run container turns it back to array or bitmap first.
+   *
+   *        (3) Memory comes from the arena if one is given, otherwise from
+   *            heap. A copy-constructed bitmap always uses heap, so it can
+   *            outlive the tree it is copied from.
+   */
+  class Tree_Bitmap_t
+  {
+  public:
+    Tree_Bitmap_t(Tree_Arena_t *arena = NULL)
+      : p_arena(arena), p_cont(NULL), n_contNum(0), n_contCap(0), n_card(0) {}
+
+    Tree_Bitmap_t(const Tree_Bitmap_t &bitmap)
+      : p_arena(NULL), p_cont(NULL), n_contNum(0), n_contCap(0), n_card(0)
+    {
+      (*this) = bitmap;
+    }
+
+    ~Tree_Bitmap_t()
+    {
+      clear();
+    }
+
+    /* copy from another bitmap, keep using the memory of this one. */
+    Tree_Bitmap_t& operator =(const Tree_Bitmap_t &bitmap)
+    {
+      if(this != &bitmap)
+      {
+        clear();
+        _reserve_cont(bitmap.n_contNum);
+        for(uint32_t m = 0; m < bitmap.n_contNum; m++)
+        {
+          _copy_cont(p_cont[m], bitmap.p_cont[m]);
         }
+        n_contNum = bitmap.n_contNum;
+        n_card = bitmap.n_card;
+      }
+      return (*this);
+    }
+
+    bool operator ==(const Tree_Bitmap_t &bitmap) const
+    {
+      if((n_card != bitmap.n_card) || (n_contNum != bitmap.n_contNum)) return false;
+      return intersect_count(bitmap) == n_card;
+    }
+
+    void clear()
+    {
+      for(uint32_t m = 0; m < n_contNum; m++)
+      {
+        _free(p_cont[m].p_data, p_cont[m].n_cap * sizeof(uint16_t));
+      }
+      _free(p_cont, n_contCap * sizeof(Tree_Cont_t));
+      p_cont = NULL;
+      n_contNum = n_contCap = 0;
+      n_card = 0;
+    }
+
+    uint64_t cardinality() const
+    {
+      return n_card;
+    }
+
+    bool empty() const
+    {
+      return n_card == 0;
+    }
+
+    /**
+     * @ret return true if id is added, false if it is already in bitmap.
+     */
+    bool add(uint32_t n_id)
+    {
+      uint32_t n_pos;
+      if(!_find_cont(static_cast<uint16_t>(n_id >> 16), n_pos))
+      {
+        _insert_cont(n_pos, static_cast<uint16_t>(n_id >> 16));
+      }
+      Tree_Cont_t &cont = p_cont[n_pos];
+      uint16_t n_low = static_cast<uint16_t>(n_id & 0xffff);
+      if(cont.e_kind == CONT_Run) _unrun_cont(cont);
+      if(cont.e_kind == CONT_Array)
+      {
+        uint16_t *arr = static_cast<uint16_t *>(cont.p_data);
+        uint32_t n_at = cont.n_card; // ids mostly come in order, try to append first.
+        if((cont.n_card != 0) && (arr[cont.n_card - 1] >= n_low))
+        {
+          n_at = static_cast<uint32_t>(std::lower_bound(arr, arr + cont.n_card, n_low) - arr);
+          if(arr[n_at] == n_low) return false;
+        }
+        if(cont.n_card < C_nArrayMax)
+        {
+          _grow_cont(cont, cont.n_card + 1);
+          arr = static_cast<uint16_t *>(cont.p_data);
+          memmove(arr + n_at + 1, arr + n_at, (cont.n_card - n_at) * sizeof(uint16_t));
+          arr[n_at] = n_low;
+          cont.n_size = ++cont.n_card;
+          n_card++;
+          return true;
+        }
+        _to_bitmapCont(cont); // array is full.
+      }
+      uint64_t *words = static_cast<uint64_t *>(cont.p_data);
+      if(words[n_low >> 6] & (1ull << (n_low & 63))) return false;
+      words[n_low >> 6] |= (1ull << (n_low & 63));
+      cont.n_card++;
+      n_card++;
+      return true;
+    }
+
+    /**
+     * @ret return true if id is removed, false if it is not in bitmap.
+     */
+    bool remove(uint32_t n_id)
+    {
+      uint32_t n_pos;
+      if(!_find_cont(static_cast<uint16_t>(n_id >> 16), n_pos)) return false;
+
+      Tree_Cont_t &cont = p_cont[n_pos];
+      uint16_t n_low = static_cast<uint16_t>(n_id & 0xffff);
+      if(!_cont_contains(cont, n_low)) return false;
+      if(cont.e_kind == CONT_Run) _unrun_cont(cont);
+      if(cont.e_kind == CONT_Array)
+      {
+        uint16_t *arr = static_cast<uint16_t *>(cont.p_data);
+        uint32_t n_at = static_cast<uint32_t>(std::lower_bound(arr, arr + cont.n_card, n_low) - arr);
+        memmove(arr + n_at, arr + n_at + 1, (cont.n_card - n_at - 1) * sizeof(uint16_t));
+        cont.n_size = --cont.n_card;
+      }
+      else
+      {
+        static_cast<uint64_t *>(cont.p_data)[n_low >> 6] &= ~(1ull << (n_low & 63));
+        if(--cont.n_card <= C_nArrayMax) _to_arrayCont(cont);
+      }
+      n_card--;
+      if(cont.n_card == 0) _erase_cont(n_pos);
+      return true;
+    }
+
+    bool contains(uint32_t n_id) const
+    {
+      uint32_t n_pos;
+      if(!_find_cont(static_cast<uint16_t>(n_id >> 16), n_pos)) return false;
+      return _cont_contains(p_cont[n_pos], static_cast<uint16_t>(n_id & 0xffff));
+    }
+
+    /**
+     * @brief This func call fn(id) for each id in bitmap, in increasing order.
+     */
+    template<class Fn>
+    void for_each(Fn fn) const
+    {
+      for(uint32_t m = 0; m < n_contNum; m++)
+      {
+        const Tree_Cont_t &cont = p_cont[m];
+        uint32_t n_high = static_cast<uint32_t>(cont.n_key) << 16;
+        if(cont.e_kind == CONT_Array)
+        {
+          const uint16_t *arr = static_cast<const uint16_t *>(cont.p_data);
+          for(uint32_t n = 0; n < cont.n_card; n++)
+          {
+            fn(n_high | arr[n]);
+          }
+        }
+        else if(cont.e_kind == CONT_Bitmap)
+        {
+          const uint64_t *words = static_cast<const uint64_t *>(cont.p_data);
+          for(uint32_t n = 0; n < C_nWordNum; n++)
+          {
+            for(uint64_t word = words[n]; word != 0; word &= word - 1)
+            {
+              fn(n_high | (n << 6) | _count_tailZero(word));
+            }
+          }
+        }
+        else
+        {
+          const uint16_t *runs = static_cast<const uint16_t *>(cont.p_data);
+          for(uint32_t n = 0; n < cont.n_size; n += 2)
+          {
+            for(uint32_t k = runs[n]; k <= static_cast<uint32_t>(runs[n]) + runs[n + 1]; k++)
+            {
+              fn(n_high | k);
+            }
+          }
+        }
+      }
+    }
+
+    /**
+     * @brief This func keep only the ids that are also in bitmap.
+     */
+    void intersect_with(const Tree_Bitmap_t &bitmap)
+    {
+      uint32_t n_num = 0, n_other = 0;
+      n_card = 0;
+      for(uint32_t m = 0; m < n_contNum; m++)
+      {
+        Tree_Cont_t &cont = p_cont[m];
+        while((n_other < bitmap.n_contNum) && (bitmap.p_cont[n_other].n_key < cont.n_key)) n_other++;
+        if((n_other < bitmap.n_contNum) && (bitmap.p_cont[n_other].n_key == cont.n_key))
+        {
+          _intersect_cont(cont, bitmap.p_cont[n_other]);
+        }
+        else
+        {
+          cont.n_card = 0;
+        }
+        n_num = _keep_cont(m, n_num);
+      }
+      n_contNum = n_num;
+    }
+
+    /**
+     * @brief This func add all ids in bitmap.
+     */
+    void union_with(const Tree_Bitmap_t &bitmap)
+    {
+      if(this == &bitmap) return;
+      if(bitmap.n_card <= C_nSmallUnion) // few ids, add them in place instead of merging containers.
+      {
+        bitmap.for_each([this](uint32_t n_id){
+          add(n_id);
+        });
+        return;
+      }
+      _reserve_cont(n_contNum + bitmap.n_contNum);
+      uint32_t n_pos = 0;
+      for(uint32_t m = 0; m < bitmap.n_contNum; m++)
+      {
+        const Tree_Cont_t &other = bitmap.p_cont[m];
+        while((n_pos < n_contNum) && (p_cont[n_pos].n_key < other.n_key)) n_pos++;
+        if((n_pos < n_contNum) && (p_cont[n_pos].n_key == other.n_key))
+        {
+          n_card -= p_cont[n_pos].n_card;
+          _union_cont(p_cont[n_pos], other);
+          n_card += p_cont[n_pos].n_card;
+        }
+        else
+        {
+          memmove(p_cont + n_pos + 1, p_cont + n_pos, (n_contNum - n_pos) * sizeof(Tree_Cont_t));
+          _copy_cont(p_cont[n_pos], other);
+          n_contNum++;
+          n_card += other.n_card;
+        }
+      }
+    }
+
+    /**
+     * @brief This func remove all ids in bitmap.
+     */
+    void subtract(const Tree_Bitmap_t &bitmap)
+    {
+      if(this == &bitmap)
+      {
+        clear();
+        return;
+      }
+      uint32_t n_num = 0, n_other = 0;
+      n_card = 0;
+      for(uint32_t m = 0; m < n_contNum; m++)
+      {
+        Tree_Cont_t &cont = p_cont[m];
+        while((n_other < bitmap.n_contNum) && (bitmap.p_cont[n_other].n_key < cont.n_key)) n_other++;
+        if((n_other < bitmap.n_contNum) && (bitmap.p_cont[n_other].n_key == cont.n_key))
+        {
+          _subtract_cont(cont, bitmap.p_cont[n_other]);
+        }
+        n_num = _keep_cont(m, n_num);
+      }
+      n_contNum = n_num;
+    }
+
+    /**
+     * @ret return number of ids in both this and bitmap, without making the result.
+     */
+    uint64_t intersect_count(const Tree_Bitmap_t &bitmap) const
+    {
+      uint64_t n_count = 0;
+      uint32_t n_other = 0;
+      for(uint32_t m = 0; (m < n_contNum) && (n_other < bitmap.n_contNum); m++)
+      {
+        while((n_other < bitmap.n_contNum) && (bitmap.p_cont[n_other].n_key < p_cont[m].n_key)) n_other++;
+        if((n_other < bitmap.n_contNum) && (bitmap.p_cont[n_other].n_key == p_cont[m].n_key))
+        {
+          n_count += _intersect_contCount(p_cont[m], bitmap.p_cont[n_other]);
+        }
+      }
+      return n_count;
+    }
+
+    /**
+     * @ret return number of runs of contiguous ids.
+     */
+    uint64_t count_runs() const
+    {
+      uint64_t n_runNum = 0;
+      for(uint32_t m = 0; m < n_contNum; m++)
+      {
+        n_runNum += _count_runs(p_cont[m]);
+        if((m != 0) && (p_cont[m].n_key == p_cont[m - 1].n_key + 1)
+           && _cont_contains(p_cont[m - 1], 0xffff) && _cont_contains(p_cont[m], 0))
+        {
+          n_runNum--; // the run goes on across containers.
+        }
+      }
+      return n_runNum;
+    }
+
+    /**
+     * @brief This func turn containers of contiguous ids into runs where it
+     *        saves memory, and release the unused capacity.
+     */
+    void run_optimize()
+    {
+      for(uint32_t m = 0; m < n_contNum; m++)
+      {
+        Tree_Cont_t &cont = p_cont[m];
+        if(cont.e_kind != CONT_Run)
+        {
+          uint32_t n_runNum = _count_runs(cont);
+          uint32_t n_curSize = (cont.e_kind == CONT_Array) ? cont.n_card : C_nWordNum * 4;
+          if(n_runNum * 2 < n_curSize)
+          {
+            _to_runCont(cont, n_runNum);
+          }
+        }
+        _shrink_cont(cont);
+      }
+    }
+
+    /**
+     * @ret return bytes of memory used by bitmap.
+     */
+    size_t get_memSize() const
+    {
+      size_t n_size = sizeof(*this) + n_contCap * sizeof(Tree_Cont_t);
+      for(uint32_t m = 0; m < n_contNum; m++)
+      {
+        n_size += p_cont[m].n_cap * sizeof(uint16_t);
+      }
+      return n_size;
+    }
+
+    /**
+     * @brief This func call fn(n_key, n_kind, n_card, p_data, n_size) for
+     *        each container in order of key, p_data is n_size uint16_t, so
+     *        append_cont() can make the same bitmap.
+     */
+    template<class Fn>
+    void for_each_cont(Fn fn) const
+    {
+      for(uint32_t m = 0; m < n_contNum; m++)
+      {
+        const Tree_Cont_t &cont = p_cont[m];
+        fn(cont.n_key, cont.e_kind, cont.n_card, static_cast<const uint16_t *>(cont.p_data), cont.n_size);
+      }
+    }
+
+    /**
+     * @brief This func add a container from for_each_cont() behind the
+     *        last one, p_data is copied and needn't be aligned.
+     *
+     * @ret   return false if its key is not above the last one, or it does
+     *        not hold n_card ids in order, the bitmap is not changed then.
+     */
+    bool append_cont(uint16_t n_key, uint16_t n_kind, uint32_t n_contCard, const void *p_data, uint32_t n_size)
+    {
+      if(((n_contNum != 0) && (p_cont[n_contNum - 1].n_key >= n_key)) || (n_contCard == 0)) return false;
+
+      Tree_Cont_t cont = {n_key, n_kind, n_contCard, n_size, std::max(n_size, 1u), NULL};
+      if(n_kind == CONT_Bitmap)
+      {
+        if(n_size != C_nWordNum * 4) return false;
+        cont.p_data = _alloc(cont.n_cap * sizeof(uint16_t));
+        memcpy(cont.p_data, p_data, n_size * sizeof(uint16_t));
+        if(_count_words(static_cast<const uint64_t *>(cont.p_data)) != n_contCard)
+        {
+          _free(cont.p_data, cont.n_cap * sizeof(uint16_t));
+          return false;
+        }
+      }
+      else if((n_kind == CONT_Array) || (n_kind == CONT_Run))
+      {
+        if(((n_kind == CONT_Array) && ((n_size != n_contCard) || (n_contCard > C_nArrayMax)))
+           || ((n_kind == CONT_Run) && ((n_size % 2) != 0))) return false;
+        cont.p_data = _alloc(cont.n_cap * sizeof(uint16_t));
+        memcpy(cont.p_data, p_data, n_size * sizeof(uint16_t));
+        const uint16_t *arr = static_cast<const uint16_t *>(cont.p_data);
+        uint32_t n_count = 0;
+        int32_t n_last = -1; // last id of container, ids and runs must be in order and apart.
+        bool is_legal = true;
+        for(uint32_t n = 0; n < n_size; n += ((n_kind == CONT_Run) ? 2 : 1))
+        {
+          uint32_t n_end = (n_kind == CONT_Run) ? static_cast<uint32_t>(arr[n]) + arr[n + 1] : arr[n];
+          if((static_cast<int32_t>(arr[n]) <= n_last) || (n_end > 0xffff))
+          {
+            is_legal = false;
+            break;
+          }
+          n_count += n_end - arr[n] + 1;
+          n_last = static_cast<int32_t>(n_end);
+        }
+        if(!is_legal || (n_count != n_contCard))
+        {
+          _free(cont.p_data, cont.n_cap * sizeof(uint16_t));
+          return false;
+        }
+      }
+      else
+      {
+        return false;
+      }
+      _reserve_cont(n_contNum + 1);
+      p_cont[n_contNum++] = cont;
+      n_card += n_contCard;
+      return true;
+    }
+
+  private:
+    friend class Tree_Column_t;
+
+    enum Tree_Cont_e
+    {
+      CONT_Array = 0,
+      CONT_Bitmap,
+      CONT_Run,
+    };
+
+    struct Tree_Cont_t
+    {
+      uint16_t n_key;                 // High 16 bits of ids in container.
+      uint16_t e_kind;                // Kind of container, Tree_Cont_e.
+      uint32_t n_card;                // Number of ids in container.
+      uint32_t n_size;                // Used uint16_t of data (array: n_card, run: 2 * runs).
+      uint32_t n_cap;                 // Allocated uint16_t of data.
+      void *p_data;                   // Data of container.
+    };
+
+    static const uint32_t C_nArrayMax = 4096;       // max ids of array container.
+    static const uint32_t C_nWordNum = 1024;        // uint64_t words of bitmap container.
+    static const uint32_t C_nSmallUnion = 16;       // union_with() adds ids one by one under this.
+
+    static uint32_t _count_tailZero(uint64_t word)
+    {
+#if defined(__GNUC__)
+      return static_cast<uint32_t>(__builtin_ctzll(word));
+#else
+      uint32_t n_count = 0;
+      for( ; !(word & 1); word >>= 1) n_count++;
+      return n_count;
+#endif
+    }
+
+    static uint32_t _count_bits(uint64_t word)
+    {
+#if defined(__GNUC__)
+      return static_cast<uint32_t>(__builtin_popcountll(word));
+#else
+      word = word - ((word >> 1) & 0x5555555555555555ull);
+      word = (word & 0x3333333333333333ull) + ((word >> 2) & 0x3333333333333333ull);
+      word = (word + (word >> 4)) & 0x0f0f0f0f0f0f0f0full;
+      return static_cast<uint32_t>((word * 0x0101010101010101ull) >> 56);
+#endif
+    }
+
+    void* _alloc(size_t n_size)
+    {
+      return (p_arena != NULL) ? p_arena->allocate(n_size) : ::operator new(n_size);
+    }
+
+    void _free(void *p_block, size_t n_size)
+    {
+      if(p_block == NULL) return;
+      if(p_arena != NULL)
+      {
+        p_arena->deallocate(p_block, n_size);
+      }
+      else
+      {
+        ::operator delete(p_block);
+      }
+    }
+
+    /**
+     * @ret return true and the position if container of key is found,
+     *      otherwise return false and the position to insert it.
+     */
+    bool _find_cont(uint16_t n_key, uint32_t &n_pos) const
+    {
+      if((n_contNum != 0) && (p_cont[n_contNum - 1].n_key <= n_key)) // ids mostly come in order, try the last first.
+      {
+        n_pos = n_contNum - ((p_cont[n_contNum - 1].n_key == n_key) ? 1 : 0);
+        return p_cont[n_contNum - 1].n_key == n_key;
+      }
+      uint32_t n_low = 0, n_high = n_contNum;
+      while(n_low < n_high)
+      {
+        uint32_t n_mid = (n_low + n_high) / 2;
+        if(p_cont[n_mid].n_key < n_key) n_low = n_mid + 1;
+        else n_high = n_mid;
+      }
+      n_pos = n_low;
+      return (n_low < n_contNum) && (p_cont[n_low].n_key == n_key);
+    }
+
+    void _reserve_cont(uint32_t n_num)
+    {
+      if(n_num > n_contCap)
+      {
+        uint32_t n_cap = std::max(n_num, n_contCap * 2);
+        Tree_Cont_t *p_new = static_cast<Tree_Cont_t *>(_alloc(n_cap * sizeof(Tree_Cont_t)));
+        if(n_contNum != 0) memcpy(p_new, p_cont, n_contNum * sizeof(Tree_Cont_t));
+        _free(p_cont, n_contCap * sizeof(Tree_Cont_t));
+        p_cont = p_new;
+        n_contCap = n_cap;
+      }
+    }
+
+    void _insert_cont(uint32_t n_pos, uint16_t n_key)
+    {
+      _reserve_cont(n_contNum + 1);
+      memmove(p_cont + n_pos + 1, p_cont + n_pos, (n_contNum - n_pos) * sizeof(Tree_Cont_t));
+      Tree_Cont_t &cont = p_cont[n_pos];
+      cont.n_key = n_key;
+      cont.e_kind = CONT_Array;
+      cont.n_card = cont.n_size = cont.n_cap = 0;
+      cont.p_data = NULL;
+      n_contNum++;
+    }
+
+    void _erase_cont(uint32_t n_pos)
+    {
+      _free(p_cont[n_pos].p_data, p_cont[n_pos].n_cap * sizeof(uint16_t));
+      memmove(p_cont + n_pos, p_cont + n_pos + 1, (n_contNum - n_pos - 1) * sizeof(Tree_Cont_t));
+      n_contNum--;
+    }
+
+    /**
+     * @note  move container m to position n_num if it is not empty, used to
+     *        drop empty containers after an operation in place.
+     *
+     * @ret   return the next position.
+     */
+    uint32_t _keep_cont(uint32_t m, uint32_t n_num)
+    {
+      if(p_cont[m].n_card == 0)
+      {
+        _free(p_cont[m].p_data, p_cont[m].n_cap * sizeof(uint16_t));
+        return n_num;
+      }
+      n_card += p_cont[m].n_card;
+      if(m != n_num) p_cont[n_num] = p_cont[m];
+      return n_num + 1;
+    }
+
+    void _copy_cont(Tree_Cont_t &cont, const Tree_Cont_t &other)
+    {
+      cont = other;
+      cont.n_cap = (other.e_kind == CONT_Bitmap) ? C_nWordNum * 4 : std::max(other.n_size, 1u);
+      cont.p_data = _alloc(cont.n_cap * sizeof(uint16_t));
+      memcpy(cont.p_data, other.p_data, cont.n_cap * sizeof(uint16_t));
+    }
+
+    /* make data hold at least n_size uint16_t of array or runs. */
+    void _grow_cont(Tree_Cont_t &cont, uint32_t n_size)
+    {
+      if(n_size > cont.n_cap)
+      {
+        uint32_t n_cap = std::max(n_size, std::min(cont.n_cap * 2, C_nArrayMax));
+        void *p_new = _alloc(n_cap * sizeof(uint16_t));
+        if(cont.n_size != 0) memcpy(p_new, cont.p_data, cont.n_size * sizeof(uint16_t));
+        _free(cont.p_data, cont.n_cap * sizeof(uint16_t));
+        cont.p_data = p_new;
+        cont.n_cap = n_cap;
+      }
+    }
+
+    void _shrink_cont(Tree_Cont_t &cont)
+    {
+      if((cont.e_kind != CONT_Bitmap) && (cont.n_size < cont.n_cap))
+      {
+        void *p_new = _alloc(cont.n_size * sizeof(uint16_t));
+        memcpy(p_new, cont.p_data, cont.n_size * sizeof(uint16_t));
+        _free(cont.p_data, cont.n_cap * sizeof(uint16_t));
+        cont.p_data = p_new;
+        cont.n_cap = cont.n_size;
+      }
+    }
+
+    /* replace data of container with a bitmap of words, keep n_card. */
+    void _set_words(Tree_Cont_t &cont, uint64_t *words)
+    {
+      if((cont.e_kind == CONT_Bitmap) && (cont.p_data == words)) return;
+      _free(cont.p_data, cont.n_cap * sizeof(uint16_t));
+      cont.e_kind = CONT_Bitmap;
+      cont.p_data = words;
+      cont.n_size = cont.n_cap = C_nWordNum * 4;
+    }
+
+    /* write ids of any container into words (C_nWordNum), words are cleared first. */
+    void _get_words(const Tree_Cont_t &cont, uint64_t *words) const
+    {
+      if(cont.e_kind == CONT_Bitmap)
+      {
+        memcpy(words, cont.p_data, C_nWordNum * sizeof(uint64_t));
+        return;
+      }
+      memset(words, 0, C_nWordNum * sizeof(uint64_t));
+      _or_words(cont, words);
+    }
+
+    /* set bits of ids in array or run container into words. */
+    static void _or_words(const Tree_Cont_t &cont, uint64_t *words)
+    {
+      const uint16_t *arr = static_cast<const uint16_t *>(cont.p_data);
+      if(cont.e_kind == CONT_Array)
+      {
+        for(uint32_t n = 0; n < cont.n_card; n++)
+        {
+          words[arr[n] >> 6] |= (1ull << (arr[n] & 63));
+        }
+      }
+      else if(cont.e_kind == CONT_Run)
+      {
+        for(uint32_t n = 0; n < cont.n_size; n += 2)
+        {
+          for(uint32_t k = arr[n]; k <= static_cast<uint32_t>(arr[n]) + arr[n + 1]; k++)
+          {
+            words[k >> 6] |= (1ull << (k & 63));
+          }
+        }
+      }
+      else
+      {
+        const uint64_t *other = static_cast<const uint64_t *>(cont.p_data);
+        for(uint32_t n = 0; n < C_nWordNum; n++)
+        {
+          words[n] |= other[n];
+        }
+      }
+    }
+
+    static uint32_t _count_words(const uint64_t *words)
+    {
+      uint32_t n_count = 0;
+      for(uint32_t n = 0; n < C_nWordNum; n++)
+      {
+        n_count += _count_bits(words[n]);
+      }
+      return n_count;
+    }
+
+    void _to_bitmapCont(Tree_Cont_t &cont)
+    {
+      uint64_t *words = static_cast<uint64_t *>(_alloc(C_nWordNum * sizeof(uint64_t)));
+      _get_words(cont, words);
+      _set_words(cont, words);
+    }
+
+    /* turn bitmap or run container of no more than C_nArrayMax ids into array. */
+    void _to_arrayCont(Tree_Cont_t &cont)
+    {
+      uint16_t *arr = static_cast<uint16_t *>(_alloc(std::max(cont.n_card, 1u) * sizeof(uint16_t)));
+      uint32_t n_num = 0;
+      if(cont.e_kind == CONT_Bitmap)
+      {
+        const uint64_t *words = static_cast<const uint64_t *>(cont.p_data);
+        for(uint32_t n = 0; n < C_nWordNum; n++)
+        {
+          for(uint64_t word = words[n]; word != 0; word &= word - 1)
+          {
+            arr[n_num++] = static_cast<uint16_t>((n << 6) | _count_tailZero(word));
+          }
+        }
+      }
+      else
+      {
+        const uint16_t *runs = static_cast<const uint16_t *>(cont.p_data);
+        for(uint32_t n = 0; n < cont.n_size; n += 2)
+        {
+          for(uint32_t k = runs[n]; k <= static_cast<uint32_t>(runs[n]) + runs[n + 1]; k++)
+          {
+            arr[n_num++] = static_cast<uint16_t>(k);
+          }
+        }
+      }
+      _free(cont.p_data, cont.n_cap * sizeof(uint16_t));
+      cont.e_kind = CONT_Array;
+      cont.p_data = arr;
+      cont.n_size = cont.n_card;
+      cont.n_cap = std::max(cont.n_card, 1u);
+    }
+
+    void _unrun_cont(Tree_Cont_t &cont)
+    {
+      if(cont.n_card <= C_nArrayMax)
+      {
+        _to_arrayCont(cont);
+      }
+      else
+      {
+        _to_bitmapCont(cont);
+      }
+    }
+
+    uint32_t _count_runs(const Tree_Cont_t &cont) const
+    {
+      uint32_t n_runNum = 0;
+      if(cont.e_kind == CONT_Array)
+      {
+        const uint16_t *arr = static_cast<const uint16_t *>(cont.p_data);
+        for(uint32_t n = 0; n < cont.n_card; n++)
+        {
+          if((n == 0) || (arr[n] != arr[n - 1] + 1)) n_runNum++;
+        }
+      }
+      else if(cont.e_kind == CONT_Bitmap)
+      {
+        const uint64_t *words = static_cast<const uint64_t *>(cont.p_data);
+        for(uint32_t n = 0; n < C_nWordNum; n++)
+        {
+          uint64_t n_carry = (n == 0) ? 0 : (words[n - 1] >> 63);
+          n_runNum += _count_bits(words[n] & ~((words[n] << 1) | n_carry)); // bits that start a run.
+        }
+      }
+      else
+      {
+        n_runNum = cont.n_size / 2;
+      }
+      return n_runNum;
+    }
+
+    void _to_runCont(Tree_Cont_t &cont, uint32_t n_runNum)
+    {
+      uint16_t *runs = static_cast<uint16_t *>(_alloc(n_runNum * 2 * sizeof(uint16_t)));
+      uint32_t n_num = 0;
+      int32_t n_last = -2;
+      _for_eachInCont(cont, [&](uint32_t n_low){
+        if(static_cast<int32_t>(n_low) == n_last + 1)
+        {
+          runs[n_num - 1]++;
+        }
+        else
+        {
+          runs[n_num++] = static_cast<uint16_t>(n_low);
+          runs[n_num++] = 0;
+        }
+        n_last = static_cast<int32_t>(n_low);
+      });
+      _free(cont.p_data, cont.n_cap * sizeof(uint16_t));
+      cont.e_kind = CONT_Run;
+      cont.p_data = runs;
+      cont.n_size = cont.n_cap = n_runNum * 2;
+    }
+
+    template<class Fn>
+    void _for_eachInCont(const Tree_Cont_t &cont, Fn fn) const
+    {
+      if(cont.e_kind == CONT_Array)
+      {
+        const uint16_t *arr = static_cast<const uint16_t *>(cont.p_data);
+        for(uint32_t n = 0; n < cont.n_card; n++) fn(arr[n]);
+      }
+      else if(cont.e_kind == CONT_Bitmap)
+      {
+        const uint64_t *words = static_cast<const uint64_t *>(cont.p_data);
+        for(uint32_t n = 0; n < C_nWordNum; n++)
+        {
+          for(uint64_t word = words[n]; word != 0; word &= word - 1)
+          {
+            fn((n << 6) | _count_tailZero(word));
+          }
+        }
+      }
+      else
+      {
+        const uint16_t *runs = static_cast<const uint16_t *>(cont.p_data);
+        for(uint32_t n = 0; n < cont.n_size; n += 2)
+        {
+          for(uint32_t k = runs[n]; k <= static_cast<uint32_t>(runs[n]) + runs[n + 1]; k++) fn(k);
+        }
+      }
+    }
+
+    bool _cont_contains(const Tree_Cont_t &cont, uint16_t n_low) const
+    {
+      if(cont.e_kind == CONT_Array)
+      {
+        const uint16_t *arr = static_cast<const uint16_t *>(cont.p_data);
+        return std::binary_search(arr, arr + cont.n_card, n_low);
+      }
+      if(cont.e_kind == CONT_Bitmap)
+      {
+        return (static_cast<const uint64_t *>(cont.p_data)[n_low >> 6] >> (n_low & 63)) & 1;
+      }
+      const uint16_t *runs = static_cast<const uint16_t *>(cont.p_data);
+      uint32_t n_low2 = 0, n_high = cont.n_size / 2; // find the last run starting at or before n_low.
+      while(n_low2 < n_high)
+      {
+        uint32_t n_mid = (n_low2 + n_high) / 2;
+        if(runs[n_mid * 2] <= n_low) n_low2 = n_mid + 1;
+        else n_high = n_mid;
+      }
+      return (n_low2 != 0) && (n_low <= static_cast<uint32_t>(runs[(n_low2 - 1) * 2]) + runs[(n_low2 - 1) * 2 + 1]);
+    }
+
+    /* keep ids of cont that are also in other, then pick the smaller kind. */
+    void _intersect_cont(Tree_Cont_t &cont, const Tree_Cont_t &other)
+    {
+      if((cont.e_kind == CONT_Array) || (other.e_kind == CONT_Array))
+      {
+        const Tree_Cont_t &arr_cont = (cont.e_kind == CONT_Array) ? cont : other;
+        const Tree_Cont_t &probe_cont = (cont.e_kind == CONT_Array) ? other : cont;
+        const uint16_t *arr = static_cast<const uint16_t *>(arr_cont.p_data);
+        uint16_t *result = static_cast<uint16_t *>(_alloc(std::max(arr_cont.n_card, 1u) * sizeof(uint16_t)));
+        uint32_t n_num = 0;
+        for(uint32_t n = 0; n < arr_cont.n_card; n++)
+        {
+          if(_cont_contains(probe_cont, arr[n])) result[n_num++] = arr[n];
+        }
+        _free(cont.p_data, cont.n_cap * sizeof(uint16_t));
+        cont.e_kind = CONT_Array;
+        cont.p_data = result;
+        cont.n_cap = std::max(arr_cont.n_card, 1u);
+        cont.n_card = cont.n_size = n_num;
+        return;
+      }
+      if(cont.e_kind == CONT_Run) _to_bitmapCont(cont);
+      uint64_t *words = static_cast<uint64_t *>(cont.p_data);
+      if(other.e_kind == CONT_Bitmap)
+      {
+        const uint64_t *other_words = static_cast<const uint64_t *>(other.p_data);
+        for(uint32_t n = 0; n < C_nWordNum; n++) words[n] &= other_words[n];
+      }
+      else
+      {
+        uint64_t arr_words[C_nWordNum];
+        _get_words(other, arr_words);
+        for(uint32_t n = 0; n < C_nWordNum; n++) words[n] &= arr_words[n];
+      }
+      cont.n_card = _count_words(words);
+      if(cont.n_card <= C_nArrayMax) _to_arrayCont(cont);
+    }
+
+    void _union_cont(Tree_Cont_t &cont, const Tree_Cont_t &other)
+    {
+      if((cont.e_kind == CONT_Array) && (other.e_kind == CONT_Array) && (cont.n_card + other.n_card <= C_nArrayMax))
+      {
+        const uint16_t *arr = static_cast<const uint16_t *>(cont.p_data);
+        const uint16_t *other_arr = static_cast<const uint16_t *>(other.p_data);
+        uint32_t n_cap = std::max(cont.n_card + other.n_card, 1u);
+        uint16_t *result = static_cast<uint16_t *>(_alloc(n_cap * sizeof(uint16_t)));
+        uint32_t n_num = static_cast<uint32_t>(std::set_union(arr, arr + cont.n_card, other_arr, other_arr + other.n_card, result) - result);
+        _free(cont.p_data, cont.n_cap * sizeof(uint16_t));
+        cont.p_data = result;
+        cont.n_cap = n_cap;
+        cont.n_card = cont.n_size = n_num;
+        return;
+      }
+      if(cont.e_kind != CONT_Bitmap) _to_bitmapCont(cont);
+      uint64_t *words = static_cast<uint64_t *>(cont.p_data);
+      if(other.e_kind == CONT_Array) // count the new ids, so many small unions do not recount all words.
+      {
+        const uint16_t *other_arr = static_cast<const uint16_t *>(other.p_data);
+        for(uint32_t n = 0; n < other.n_card; n++)
+        {
+          uint64_t n_bit = 1ull << (other_arr[n] & 63);
+          cont.n_card += ((words[other_arr[n] >> 6] & n_bit) == 0);
+          words[other_arr[n] >> 6] |= n_bit;
+        }
+        return;
+      }
+      _or_words(other, words);
+      cont.n_card = _count_words(words);
+    }
+
+    void _subtract_cont(Tree_Cont_t &cont, const Tree_Cont_t &other)
+    {
+      if(cont.e_kind == CONT_Array)
+      {
+        uint16_t *arr = static_cast<uint16_t *>(cont.p_data);
+        uint32_t n_num = 0;
+        for(uint32_t n = 0; n < cont.n_card; n++)
+        {
+          if(!_cont_contains(other, arr[n])) arr[n_num++] = arr[n];
+        }
+        cont.n_card = cont.n_size = n_num;
+        return;
+      }
+      if(cont.e_kind == CONT_Run) _to_bitmapCont(cont);
+      uint64_t *words = static_cast<uint64_t *>(cont.p_data);
+      uint64_t other_words[C_nWordNum];
+      _get_words(other, other_words);
+      for(uint32_t n = 0; n < C_nWordNum; n++) words[n] &= ~other_words[n];
+      cont.n_card = _count_words(words);
+      if(cont.n_card <= C_nArrayMax) _to_arrayCont(cont);
+    }
+
+    uint64_t _intersect_contCount(const Tree_Cont_t &cont, const Tree_Cont_t &other) const
+    {
+      uint64_t n_count = 0;
+      if((cont.e_kind == CONT_Array) || (other.e_kind == CONT_Array))
+      {
+        const Tree_Cont_t &arr_cont = (cont.e_kind == CONT_Array) ? cont : other;
+        const Tree_Cont_t &probe_cont = (cont.e_kind == CONT_Array) ? other : cont;
+        const uint16_t *arr = static_cast<const uint16_t *>(arr_cont.p_data);
+        for(uint32_t n = 0; n < arr_cont.n_card; n++)
+        {
+          if(_cont_contains(probe_cont, arr[n])) n_count++;
+        }
+        return n_count;
+      }
+      uint64_t words[C_nWordNum], other_words[C_nWordNum];
+      _get_words(cont, words);
+      _get_words(other, other_words);
+      for(uint32_t n = 0; n < C_nWordNum; n++)
+      {
+        n_count += _count_bits(words[n] & other_words[n]);
+      }
+      return n_count;
+    }
+
+    Tree_Arena_t *p_arena;            // Arena that memory comes from, NULL for heap.
+    Tree_Cont_t *p_cont;              // Containers, sorted by key.
+    uint32_t n_contNum;               // Number of containers.
+    uint32_t n_contCap;               // Allocated containers.
+    uint64_t n_card;                  // Number of ids in bitmap.
+  };
+
+  const uint32_t Tree_Bitmap_t::C_nArrayMax;
+  const uint32_t Tree_Bitmap_t::C_nWordNum;
+  const uint32_t Tree_Bitmap_t::C_nSmallUnion;
+
+  /**
+   * @brief A dense column of numbers indexed by batch index, used instead
+   *        of members by items whose values are mostly distinct.
+   *
+   * @note  (1) Slot m holds the value of batch n_base + m, v_validWord has
+   *            a bit set for each slot with a value, and v_intWord for each
+   *            value of VAL_Int. Ints are kept as double, which is exact.
+   *
+   *        (2) n_base is a multiple of 64 and v_val is padded to whole words,
+   *            so a word of validity covers 64 slots with no tail.
+   *
+   *        (3) Scan kernels use AVX2 or SSE2 if the cpu has them, checked
+   *            once at run time, otherwise they are scalar.
+   */
+  class Tree_Column_t
+  {
+  public:
+    Tree_Column_t() : n_base(0), n_card(0) {}
+
+    uint64_t cardinality() const
+    {
+      return n_card;
+    }
+
+    bool empty() const
+    {
+      return n_card == 0;
+    }
+
+    bool contains(uint32_t n_id) const
+    {
+      size_t n_slot;
+      return _find_slot(n_id, n_slot) && _test_bit(v_validWord, n_slot);
+    }
+
+    /**
+     * @ret return the number of slots from the first value, or id n_id if
+     *      it is lower, to the last value, or n_id if it is higher.
+     */
+    uint64_t get_span(uint32_t n_id) const
+    {
+      if(v_val.empty()) return 1;
+      uint64_t n_low = std::min<uint64_t>(n_base, n_id), n_high = std::max<uint64_t>(n_base + v_val.size() - 1, n_id);
+      return n_high - n_low + 1;
+    }
+
+    /**
+     * @ret return false if s_val is not a number, the column is not changed.
+     */
+    bool set(uint32_t n_id, const Tree_Val_t &s_val)
+    {
+      if((s_val.e_type != VAL_Int) && (s_val.e_type != VAL_Double)) return false;
+
+      size_t n_slot;
+      if(!_find_slot(n_id, n_slot))
+      {
+        _grow(n_id);
+        _find_slot(n_id, n_slot);
+      }
+      if(!_test_bit(v_validWord, n_slot))
+      {
+        v_validWord[n_slot >> 6] |= (1ull << (n_slot & 63));
+        n_card++;
+      }
+      if(s_val.e_type == VAL_Int)
+      {
+        v_val[n_slot] = s_val.u_val.val_int;
+        v_intWord[n_slot >> 6] |= (1ull << (n_slot & 63));
+      }
+      else
+      {
+        v_val[n_slot] = s_val.u_val.val_double;
+        v_intWord[n_slot >> 6] &= ~(1ull << (n_slot & 63));
+      }
+      return true;
+    }
+
+    bool remove(uint32_t n_id)
+    {
+      size_t n_slot;
+      if(_find_slot(n_id, n_slot) && _test_bit(v_validWord, n_slot))
+      {
+        v_validWord[n_slot >> 6] &= ~(1ull << (n_slot & 63));
+        n_card--;
+        return true;
+      }
+      return false;
+    }
+
+    /**
+     * @ret return false if batch n_id has no value.
+     */
+    bool get(uint32_t n_id, Tree_Val_t &s_val) const
+    {
+      size_t n_slot;
+      if(_find_slot(n_id, n_slot) && _test_bit(v_validWord, n_slot))
+      {
+        _get_slotVal(n_slot, s_val);
+        return true;
+      }
+      return false;
+    }
+
+    /**
+     * @brief This func call fn(n_id, s_val) for each value in order of id.
+     */
+    template<class Fn>
+    void for_each(Fn fn) const
+    {
+      Tree_Val_t s_val;
+      for(size_t m = 0; m < v_validWord.size(); m++)
+      {
+        for(uint64_t n_word = v_validWord[m]; n_word != 0; n_word &= (n_word - 1))
+        {
+          size_t n_slot = (m << 6) + _get_lowBit(n_word);
+          _get_slotVal(n_slot, s_val);
+          fn(static_cast<uint32_t>(n_base + n_slot), s_val);
+        }
+      }
+    }
+
+    /**
+     * @brief This func find the ids whose value matches a predicate, same
+     *        as matching the values one by one by xmlTree::_match_pred().
+     */
+    void query(const Tree_Pred_t &s_pred, Tree_Bitmap_t &bm_result) const
+    {
+      bm_result.clear();
+      _scan(s_pred, [&](size_t n_word, uint64_t n_mask){
+        for( ; n_mask != 0; n_mask &= (n_mask - 1))
+        {
+          bm_result.add(static_cast<uint32_t>(n_base + (n_word << 6) + _get_lowBit(n_mask))); // ids are increasing, so it is appended.
+        }
+      });
+    }
+
+    uint64_t count(const Tree_Pred_t &s_pred) const
+    {
+      uint64_t n_count = 0;
+      _scan(s_pred, [&](size_t n_word, uint64_t n_mask){
+        n_count += Tree_Bitmap_t::_count_bits(n_mask);
+      });
+      return n_count;
+    }
+
+    /**
+     * @brief This func compute count, sum, min, max and average of the
+     *        values, NaN is skipped. The ids are limited to bm_filter if it
+     *        is not NULL.
+     */
+    void stat(Tree_Stat_t &s_stat, const Tree_Bitmap_t *bm_filter = NULL) const
+    {
+      memset(&s_stat, 0, sizeof(s_stat));
+      if(v_val.empty()) return;
+
+      const uint64_t *p_valid = &v_validWord[0];
+      std::vector<uint64_t> v_filterWord;
+      if(bm_filter != NULL) // keep the valid slots in filter.
+      {
+        uint64_t n_end = n_base + v_val.size();
+        v_filterWord.assign(v_validWord.size(), 0);
+        bm_filter->for_each([&](uint32_t n_id){
+          if((n_id >= n_base) && (n_id < n_end))
+          {
+            size_t n_slot = n_id - n_base;
+            v_filterWord[n_slot >> 6] |= (1ull << (n_slot & 63));
+          }
+        });
+        for(size_t m = 0; m < v_filterWord.size(); m++)
+        {
+          v_filterWord[m] &= v_validWord[m];
+        }
+        p_valid = &v_filterWord[0];
+      }
+
+      switch(_get_simdLevel())
+      {
+#if defined(TREE_SIMD_X86)
+      case SIMD_Avx2:
+        _stat_avx2(&v_val[0], p_valid, v_val.size(), s_stat);
+        break;
+      case SIMD_Sse2:
+        _stat_sse2(&v_val[0], p_valid, v_val.size(), s_stat);
+        break;
+#endif
+      default:
+        _stat_scalar(&v_val[0], p_valid, v_val.size(), s_stat);
+        break;
+      }
+      if(s_stat.n_count != 0) s_stat.d_avg = s_stat.d_sum / s_stat.n_count;
+    }
+
+    /**
+     * @brief This func drop the words of no value at both ends, and release
+     *        the unused capacity.
+     */
+    void shrink()
+    {
+      size_t n_first = 0, n_last = v_validWord.size();
+      while((n_first < n_last) && (v_validWord[n_first] == 0)) n_first++;
+      while((n_last > n_first) && (v_validWord[n_last - 1] == 0)) n_last--;
+      std::vector<double>(v_val.begin() + (n_first << 6), v_val.begin() + (n_last << 6)).swap(v_val);
+      std::vector<uint64_t>(v_validWord.begin() + n_first, v_validWord.begin() + n_last).swap(v_validWord);
+      std::vector<uint64_t>(v_intWord.begin() + n_first, v_intWord.begin() + n_last).swap(v_intWord);
+      n_base += n_first << 6;
+    }
+
+    /**
+     * @ret return bytes of memory used by column.
+     */
+    size_t get_memSize() const
+    {
+      return sizeof(*this) + v_val.capacity() * sizeof(double)
+             + (v_validWord.capacity() + v_intWord.capacity()) * sizeof(uint64_t);
+    }
+
+  private:
+    enum Tree_Simd_e
+    {
+      SIMD_None = 0,
+      SIMD_Sse2,
+      SIMD_Avx2,
+    };
+
+    /**
+     * @ret return the widest instruction set of the cpu, checked once.
+     */
+    static Tree_Simd_e _get_simdLevel()
+    {
+#if defined(TREE_SIMD_X86)
+      static const Tree_Simd_e e_level = __builtin_cpu_supports("avx2") ? SIMD_Avx2
+                                         : (__builtin_cpu_supports("sse2") ? SIMD_Sse2 : SIMD_None);
+      return e_level;
+#else
+      return SIMD_None;
+#endif
+    }
+
+    static uint32_t _get_lowBit(uint64_t n_word)
+    {
+#if defined(__GNUC__)
+      return static_cast<uint32_t>(__builtin_ctzll(n_word));
+#else
+      return Tree_Bitmap_t::_count_bits((n_word & (0 - n_word)) - 1);
+#endif
+    }
+
+    static bool _test_bit(const std::vector<uint64_t> &v_word, size_t n_slot)
+    {
+      return (v_word[n_slot >> 6] >> (n_slot & 63)) & 1;
+    }
+
+    bool _find_slot(uint32_t n_id, size_t &n_slot) const
+    {
+      n_slot = n_id - n_base;
+      return (n_id >= n_base) && (n_slot < v_val.size());
+    }
+
+    void _get_slotVal(size_t n_slot, Tree_Val_t &s_val) const
+    {
+      s_val.n_memLen = 0;
+      if(_test_bit(v_intWord, n_slot))
+      {
+        s_val.e_type = VAL_Int;
+        s_val.u_val.val_int = static_cast<int>(v_val[n_slot]);
+      }
+      else
+      {
+        s_val.e_type = VAL_Double;
+        s_val.u_val.val_double = v_val[n_slot];
+      }
+    }
+
+    /**
+     * @brief This func grow the column to hold id n_id, by whole words. It
+     *        grows in front by at least the words it has, so adding lower
+     *        ids one by one does not move the values each time.
+     */
+    void _grow(uint32_t n_id)
+    {
+      uint64_t n_first = n_id & ~static_cast<uint64_t>(63);
+      if(v_val.empty())
+      {
+        n_base = n_first;
+      }
+      else if(n_first < n_base) // grow in front.
+      {
+        uint64_t n_room = n_base - std::min<uint64_t>(n_base, v_val.size()); // lowest base by doubling, not below 0.
+        n_first = std::min(n_first, n_room);
+        size_t n_wordNum = static_cast<size_t>((n_base - n_first) >> 6);
+        v_val.insert(v_val.begin(), n_wordNum << 6, 0.0);
+        v_validWord.insert(v_validWord.begin(), n_wordNum, 0);
+        v_intWord.insert(v_intWord.begin(), n_wordNum, 0);
+        n_base = n_first;
+        return;
+      }
+      size_t n_wordNum = static_cast<size_t>(((n_first - n_base) >> 6) + 1);
+      v_val.resize(n_wordNum << 6, 0.0);
+      v_validWord.resize(n_wordNum, 0);
+      v_intWord.resize(n_wordNum, 0);
+    }
+
+    /**
+     * @brief This func call fn(n_word, n_mask) for each word of slots with
+     *        a matched value, n_mask has a bit for each of them.
+     *
+     * @note  (1) Every predicate is turned into ranges of low and high bound,
+     *            open or closed, the compares are ordered so NaN never
+     *            matches. PRED_NotEqual is the two ranges beside s_val.
+     *
+     *        (2) Strings never match, as well as PRED_Prefix.
+     */
+    template<class Fn>
+    void _scan(const Tree_Pred_t &s_pred, Fn fn) const
+    {
+      const double d_inf = std::numeric_limits<double>::infinity();
+      double d_val, d_high;
+      double arr_low[2], arr_high[2];
+      bool arr_lowOpen[2] = {false, false}, arr_highOpen[2] = {false, false};
+      int n_rangeNum = 1;
+
+      if(!_get_predNum(s_pred.s_val, d_val)) return;
+      arr_low[0] = -d_inf;
+      arr_high[0] = d_inf;
+      switch(s_pred.e_op)
+      {
+      case PRED_Equal:
+        arr_low[0] = arr_high[0] = d_val;
+        break;
+      case PRED_NotEqual:
+        arr_high[0] = d_val;
+        arr_highOpen[0] = true;
+        arr_low[1] = d_val;
+        arr_lowOpen[1] = true;
+        arr_high[1] = d_inf;
+        n_rangeNum = 2;
+        break;
+      case PRED_Less:
+        arr_high[0] = d_val;
+        arr_highOpen[0] = true;
+        break;
+      case PRED_LessEqual:
+        arr_high[0] = d_val;
+        break;
+      case PRED_Greater:
+        arr_low[0] = d_val;
+        arr_lowOpen[0] = true;
+        break;
+      case PRED_GreaterEqual:
+        arr_low[0] = d_val;
+        break;
+      case PRED_Between:
+        if(!_get_predNum(s_pred.s_valHigh, d_high)) return;
+        arr_low[0] = d_val;
+        arr_high[0] = d_high;
+        break;
+      default:
+        return;
+      }
+
+      Tree_Simd_e e_level = _get_simdLevel();
+      for(size_t m = 0; m < v_validWord.size(); m++)
+      {
+        if(v_validWord[m] == 0) continue;
+        uint64_t n_mask = 0;
+        for(int n = 0; n < n_rangeNum; n++)
+        {
+          const double *p_val = &v_val[m << 6];
+          switch(e_level)
+          {
+#if defined(TREE_SIMD_X86)
+          case SIMD_Avx2:
+            n_mask |= _scan_avx2(p_val, arr_low[n], arr_lowOpen[n], arr_high[n], arr_highOpen[n]);
+            break;
+          case SIMD_Sse2:
+            n_mask |= _scan_sse2(p_val, arr_low[n], arr_lowOpen[n], arr_high[n], arr_highOpen[n]);
+            break;
+#endif
+          default:
+            n_mask |= _scan_scalar(p_val, arr_low[n], arr_lowOpen[n], arr_high[n], arr_highOpen[n]);
+            break;
+          }
+        }
+        n_mask &= v_validWord[m];
+        if(n_mask != 0) fn(m, n_mask);
+      }
+    }
+
+    /**
+     * @ret return false if s_val is not a number, NaN is a number here and
+     *         matches nothing.
+     */
+    static bool _get_predNum(const Tree_Val_t &s_val, double &d_val)
+    {
+      if(s_val.e_type == VAL_Int) d_val = s_val.u_val.val_int;
+      else if(s_val.e_type == VAL_Double) d_val = s_val.u_val.val_double;
+      else return false;
+      return true;
+    }
+
+    /**
+     * @ret return mask of the 64 values from p_val in the range.
+     */
+    static uint64_t _scan_scalar(const double *p_val, double d_low, bool is_lowOpen, double d_high, bool is_highOpen)
+    {
+      uint64_t n_mask = 0;
+      for(uint32_t m = 0; m < 64; m++)
+      {
+        double d_val = p_val[m];
+        bool is_match = (is_lowOpen ? (d_val > d_low) : (d_val >= d_low))
+                        && (is_highOpen ? (d_val < d_high) : (d_val <= d_high));
+        n_mask |= static_cast<uint64_t>(is_match) << m;
+      }
+      return n_mask;
+    }
+
+    static void _stat_scalar(const double *p_val, const uint64_t *p_valid, size_t n_slotNum, Tree_Stat_t &s_stat)
+    {
+      for(size_t m = 0; m < n_slotNum; m++)
+      {
+        double d_val = p_val[m];
+        if(!((p_valid[m >> 6] >> (m & 63)) & 1) || (d_val != d_val)) continue;
+        if((s_stat.n_count == 0) || (d_val < s_stat.d_min)) s_stat.d_min = d_val;
+        if((s_stat.n_count == 0) || (d_val > s_stat.d_max)) s_stat.d_max = d_val;
+        s_stat.n_count++;
+        s_stat.d_sum += d_val;
+      }
+    }
+
+#if defined(TREE_SIMD_X86)
+    __attribute__((target("sse2")))
+    static uint64_t _scan_sse2(const double *p_val, double d_low, bool is_lowOpen, double d_high, bool is_highOpen)
+    {
+      __m128d v_low = _mm_set1_pd(d_low), v_high = _mm_set1_pd(d_high);
+      uint64_t n_mask = 0;
+      for(uint32_t m = 0; m < 64; m += 2)
+      {
+        __m128d v_val = _mm_loadu_pd(p_val + m);
+        __m128d v_lowCmp = is_lowOpen ? _mm_cmpgt_pd(v_val, v_low) : _mm_cmpge_pd(v_val, v_low);
+        __m128d v_highCmp = is_highOpen ? _mm_cmplt_pd(v_val, v_high) : _mm_cmple_pd(v_val, v_high);
+        n_mask |= static_cast<uint64_t>(_mm_movemask_pd(_mm_and_pd(v_lowCmp, v_highCmp))) << m;
+      }
+      return n_mask;
+    }
+
+    __attribute__((target("avx2")))
+    static uint64_t _scan_avx2(const double *p_val, double d_low, bool is_lowOpen, double d_high, bool is_highOpen)
+    {
+      __m256d v_low = _mm256_set1_pd(d_low), v_high = _mm256_set1_pd(d_high);
+      uint64_t n_mask = 0;
+      for(uint32_t m = 0; m < 64; m += 4)
+      {
+        __m256d v_val = _mm256_loadu_pd(p_val + m);
+        __m256d v_lowCmp = is_lowOpen ? _mm256_cmp_pd(v_val, v_low, _CMP_GT_OQ) : _mm256_cmp_pd(v_val, v_low, _CMP_GE_OQ);
+        __m256d v_highCmp = is_highOpen ? _mm256_cmp_pd(v_val, v_high, _CMP_LT_OQ) : _mm256_cmp_pd(v_val, v_high, _CMP_LE_OQ);
+        n_mask |= static_cast<uint64_t>(_mm256_movemask_pd(_mm256_and_pd(v_lowCmp, v_highCmp))) << m;
+      }
+      return n_mask;
+    }
+
+    __attribute__((target("sse2")))
+    static void _stat_sse2(const double *p_val, const uint64_t *p_valid, size_t n_slotNum, Tree_Stat_t &s_stat)
+    {
+      const double d_inf = std::numeric_limits<double>::infinity();
+      __m128d v_sum = _mm_setzero_pd(), v_min = _mm_set1_pd(d_inf), v_max = _mm_set1_pd(-d_inf);
+      __m128d v_inf = _mm_set1_pd(d_inf), v_negInf = _mm_set1_pd(-d_inf);
+      uint64_t n_count = 0;
+      for(size_t m = 0; m < n_slotNum; m += 2)
+      {
+        uint64_t n_bits = (p_valid[m >> 6] >> (m & 63)) & 3;
+        if(n_bits == 0) continue;
+        __m128d v_val = _mm_loadu_pd(p_val + m);
+        __m128d v_mask = _mm_castsi128_pd(_mm_set_epi64x(-static_cast<int64_t>(n_bits >> 1), -static_cast<int64_t>(n_bits & 1)));
+        v_mask = _mm_and_pd(v_mask, _mm_cmpord_pd(v_val, v_val));
+        v_sum = _mm_add_pd(v_sum, _mm_and_pd(v_mask, v_val));
+        v_min = _mm_min_pd(v_min, _mm_or_pd(_mm_and_pd(v_mask, v_val), _mm_andnot_pd(v_mask, v_inf)));
+        v_max = _mm_max_pd(v_max, _mm_or_pd(_mm_and_pd(v_mask, v_val), _mm_andnot_pd(v_mask, v_negInf)));
+        n_count += Tree_Bitmap_t::_count_bits(static_cast<uint64_t>(_mm_movemask_pd(v_mask)));
+      }
+      double arr_sum[2], arr_min[2], arr_max[2];
+      _mm_storeu_pd(arr_sum, v_sum);
+      _mm_storeu_pd(arr_min, v_min);
+      _mm_storeu_pd(arr_max, v_max);
+      _merge_lanes(arr_sum, arr_min, arr_max, 2, n_count, s_stat);
+    }
+
+    __attribute__((target("avx2")))
+    static void _stat_avx2(const double *p_val, const uint64_t *p_valid, size_t n_slotNum, Tree_Stat_t &s_stat)
+    {
+      const double d_inf = std::numeric_limits<double>::infinity();
+      __m256d v_sum = _mm256_setzero_pd(), v_min = _mm256_set1_pd(d_inf), v_max = _mm256_set1_pd(-d_inf);
+      __m256d v_inf = _mm256_set1_pd(d_inf), v_negInf = _mm256_set1_pd(-d_inf);
+      __m256i v_lane = _mm256_set_epi64x(8, 4, 2, 1);
+      uint64_t n_count = 0;
+      for(size_t m = 0; m < n_slotNum; m += 4)
+      {
+        uint64_t n_bits = (p_valid[m >> 6] >> (m & 63)) & 15;
+        if(n_bits == 0) continue;
+        __m256d v_val = _mm256_loadu_pd(p_val + m);
+        __m256i v_bits = _mm256_and_si256(_mm256_set1_epi64x(static_cast<int64_t>(n_bits)), v_lane);
+        __m256d v_mask = _mm256_castsi256_pd(_mm256_cmpeq_epi64(v_bits, v_lane));
+        v_mask = _mm256_and_pd(v_mask, _mm256_cmp_pd(v_val, v_val, _CMP_ORD_Q));
+        v_sum = _mm256_add_pd(v_sum, _mm256_and_pd(v_mask, v_val));
+        v_min = _mm256_min_pd(v_min, _mm256_blendv_pd(v_inf, v_val, v_mask));
+        v_max = _mm256_max_pd(v_max, _mm256_blendv_pd(v_negInf, v_val, v_mask));
+        n_count += Tree_Bitmap_t::_count_bits(static_cast<uint64_t>(_mm256_movemask_pd(v_mask)));
+      }
+      double arr_sum[4], arr_min[4], arr_max[4];
+      _mm256_storeu_pd(arr_sum, v_sum);
+      _mm256_storeu_pd(arr_min, v_min);
+      _mm256_storeu_pd(arr_max, v_max);
+      _merge_lanes(arr_sum, arr_min, arr_max, 4, n_count, s_stat);
+    }
+
+    static void _merge_lanes(const double *arr_sum, const double *arr_min, const double *arr_max, int n_laneNum, uint64_t n_count, Tree_Stat_t &s_stat)
+    {
+      s_stat.n_count = n_count;
+      if(n_count == 0) return;
+      s_stat.d_sum = arr_sum[0];
+      s_stat.d_min = arr_min[0];
+      s_stat.d_max = arr_max[0];
+      for(int m = 1; m < n_laneNum; m++)
+      {
+        s_stat.d_sum += arr_sum[m];
+        s_stat.d_min = std::min(s_stat.d_min, arr_min[m]);
+        s_stat.d_max = std::max(s_stat.d_max, arr_max[m]);
+      }
+    }
+#endif
+
+    uint64_t n_base;                  // Id of slot 0, multiple of 64.
+    std::vector<double> v_val;        // Values by slot, 0 if no value.
+    std::vector<uint64_t> v_validWord; // Bits of slots with value.
+    std::vector<uint64_t> v_intWord;  // Bits of slots with a VAL_Int value.
+    uint64_t n_card;                  // Number of values.
+  };
+
+
+  /**
+   * @brief A class to build and access the xml tree.
+   *
+   * @note  (1) How to use this class:
+   *            1. Use build_tree_fromXmlFile() to build the tree from
+   *               "xml_name.xml".
+   *            2. Use add_batch_fromXmlFile() to set batches of value
+   *               to items in tree from "xml_val.xml", or use
+   *               add_batch_fromXmlStream() if the file is too large to
+   *               load at once.
+   *               (build_tree_fromXmlMapping() and add_batch_fromXmlMapping()
+   *               do the same by mapping the file instead of copying it.)
+   *            3. Then a tree with user value is built, use other function
+   *               to operate the user value.
+   *
+   *        (2) Since the tree item's id is type uint64_t (Tree_Id_t), where
+   *            one layer needs FORMAT_Item_Bits bits to set the index from
+   *            1 ~ (1 << FORMAT_Item_Bits) - 1, the max number of child
+   *            items of each item is (1 << FORMAT_Item_Bits) - 1, the max
+   *            number of layer of tree is 64 / FORMAT_Item_Bits (15 and 16
+   *            by default).
+   *
+   *        (3) Also look "xml_name.xml" and "xml_val.xml" to know more
+   *            well about how to use.
+   */
+  class xmlSharedTree;
+
+  class xmlTree
+  {
+    struct Tree_Item_t;
+
+  public:
+#define FORMAT_Item_Id         16                 // item id use hex format.
+#define FORMAT_Batch_Index     10                 // batch index use 10 format.
+#ifndef FORMAT_Item_Bits
+  #define FORMAT_Item_Bits     4                  // bits of index of item in each layer of id, define it before including to change.
+#endif
+
+    /**
+     * @note  Id of item, the index of item in each layer from root takes
+     *        FORMAT_Item_Bits bits from the lowest, such as 0x21 for the
+     *        second child of the first child of root by default. So there
+     *        are 64 / FORMAT_Item_Bits layers, and (1 << FORMAT_Item_Bits) - 1
+     *        childs in each item at most.
+     */
+    typedef uint64_t Tree_Id_t;
+
+    /**
+     * @note  Handle of an item resolved by get_itemHandle(), pass it
+     *        instead of item's name to skip the name lookup. NULL means
+     *        no item.
+     */
+    typedef const Tree_Item_t* Tree_Handle_t;
+
+    /**
+     * @note  Value of one item in a batch, see get_oneBatchView().
+     */
+    struct Tree_ItemView_t
+    {
+      Tree_Handle_t h_item;             // Handle of item.
+      const char* str_itemName;         // Name of item, valid until the tree is destroyed.
+      Tree_ValView_t s_val;             // Value of item in the batch.
+    };
+
+    /**
+     * @brief Struct of node of query, a tree of predicates on items joined
+     *        by AND, OR and NOT, such as
+     *        "class == 'Class 1' AND weight >= 50 AND NOT height >= 1.7".
+     *
+     * @note  (1) Build it by make_query(), make_andQuery(), make_orQuery()
+     *            and make_notQuery(), more childs of AND and OR can be
+     *            pushed into v_child.
+     *
+     *        (2) NOT is taken against all batches of tree, a batch without
+     *            value of the item matches NOT of any predicate on it.
+     */
+    struct Tree_Query_t
+    {
+      Tree_Query_e e_op;                // Operator of node.
+      Tree_Handle_t h_item;             // Item of QUERY_Pred.
+      Tree_Pred_t s_pred;               // Predicate of QUERY_Pred.
+      std::vector<Tree_Query_t> v_child; // Childs of QUERY_And, QUERY_Or and QUERY_Not.
+    };
+
+    static Tree_Query_t make_query(Tree_Handle_t h_item, const Tree_Pred_t &s_pred)
+    {
+      Tree_Query_t s_query = {QUERY_Pred, h_item, s_pred, std::vector<Tree_Query_t>()};
+      return s_query;
+    }
+
+    static Tree_Query_t make_andQuery(const Tree_Query_t &s_queryA, const Tree_Query_t &s_queryB)
+    {
+      Tree_Query_t s_query = {QUERY_And, NULL, s_queryA.s_pred, std::vector<Tree_Query_t>()};
+      s_query.v_child.push_back(s_queryA);
+      s_query.v_child.push_back(s_queryB);
+      return s_query;
+    }
+
+    static Tree_Query_t make_orQuery(const Tree_Query_t &s_queryA, const Tree_Query_t &s_queryB)
+    {
+      Tree_Query_t s_query = make_andQuery(s_queryA, s_queryB);
+      s_query.e_op = QUERY_Or;
+      return s_query;
+    }
+
+    static Tree_Query_t make_notQuery(const Tree_Query_t &s_queryA)
+    {
+      Tree_Query_t s_query = {QUERY_Not, NULL, s_queryA.s_pred, std::vector<Tree_Query_t>(1, s_queryA)};
+      return s_query;
+    }
+
+    xmlTree() : s_rootItem(&s_arena), s_strPool(&s_arena), bm_batchIndex(&s_arena)
+    {
+      _add_itemToTable(&s_rootItem, C_nNoItem, C_nNoItem, 0);
+    }
+
+    ~xmlTree()
+    {
+      s_arena.set_releasing(); // members are freed with the arena, skip them.
+      _free_itemTree();
+      for(auto iter = l_fileMap.begin(); iter != l_fileMap.end(); ++iter)
+      {
+        delete (*iter); // members do not use the mapped files any more.
+      }
+      l_fileMap.clear();
+      __logMsg("xml tree free succ\r\n.");
+    }
+
+    /**
+     * @brief This func build the tree by "xml_name.xml",which contains
+     *        the name of item and structure of tree.
+     *
+     * @input str_xml_name: name of xml file.
+	 *
+	 * @ret   return ERR_None if success otherwise return error code.
+     */
+    int build_tree_fromXmlFile(const char* str_xml_name)
+    {
+      int ret = ERR_None;
+
+      rapidxml::file<> xml_file(str_xml_name);
+      ret = _build_tree(xml_file.data());
+
+      return ret;
+    }
+
+    /**
+     * @brief This func build the tree like build_tree_fromXmlFile(), but
+     *        parses the file in place in a memory mapping of it.
+     *
+     * @input str_xml_name: name of xml file.
+     *
+     * @ret   return ERR_None if success otherwise return error code.
+     *
+     * @note  (1) Items copy their names, so the file is unmapped when
+     *            the tree is built.
+     */
+    int build_tree_fromXmlMapping(const char* str_xml_name)
+    {
+      int ret = ERR_OpenFile;
+
+      Tree_FileMap_t xml_file;
+      if(xml_file.map_file(str_xml_name))
+      {
+        ret = _build_tree(xml_file.data());
+      }
+
+      return ret;
+    }
+
+    /**
+     * @brief This func set batches of value of item by an xml file,
+     *        which stores batches of value in parallel mode.
+     *
+     * @input str_xml_val: name of value xml file.
+	 *
+	 * @ret   return ERR_None if success otherwise return error code.
+     */
+    int add_batch_fromXmlFile(const char* str_xml_val)
+    {
+      int ret = ERR_None;
+
+      rapidxml::file<> xml_file(str_xml_val);
+      ret = _add_batches(xml_file.data());
+
+      return ret;
+    }
+
+    /**
+     * @brief This func set batches of value like add_batch_fromXmlFile(),
+     *        but parses the file in place in a memory mapping of it.
+     *
+     * @input str_xml_val: name of value xml file.
+     *
+     * @ret   return ERR_None if success otherwise return error code.
+     *
+     * @note  (1) Parsing in place writes to every page of the mapping, so
+     *            string values are copied into the pool like
+     *            add_batch_fromXmlFile(), and the file is unmapped when
+     *            the batches are added.
+     */
+    int add_batch_fromXmlMapping(const char* str_xml_val)
+    {
+      int ret = ERR_OpenFile;
+
+      Tree_FileMap_t xml_file;
+      if(xml_file.map_file(str_xml_val))
+      {
+        ret = _add_batches(xml_file.data());
+      }
+
+      return ret;
+    }
+
+    /**
+     * @brief This func set batches of value of item by an xml file like
+     *        add_batch_fromXmlFile(), but reads the file by chunks and
+     *        parses one "Batch" element at a time, so the memory used
+     *        is bounded by the size of one batch, not the whole file.
+     *
+     * @input str_xml_val: name of value xml file.
+     *
+     * @ret   return ERR_None if success otherwise return error code.
+     *
+     * @note  (1) Only "Batch" elements are read, everything else in the
+     *            file (declaration, comments, root node) is skipped.
+     *
+     *        (2) If the file ends in a batch, the batches before it are
+     *            added and ERR_IllegalFile is returned.
+     */
+    int add_batch_fromXmlStream(const char* str_xml_val)
+    {
+      int ret = ERR_OpenFile;
+
+      FILE *p_file = fopen(str_xml_val, "rb");
+      if(p_file != NULL)
+      {
+        ret = ERR_None;
+        std::vector<char> v_window; // bytes read from file but not consumed.
+        std::vector<char> v_batch; // text of current batch.
+        rapidxml::xml_document<> xml_doc;
+        Tree_BatchPlan_t s_plan; // names are copied, so it outlives the text of batch.
+        /* use a loop to get all bathes of value in xml file. */
+        while(_read_batchFromStream(p_file, v_window, v_batch))
+        {
+          xml_doc.clear(); // free the nodes of last batch.
+          xml_doc.parse<0>(&v_batch[0]);
+          if((ret = _add_batch(xml_doc.first_node(), s_plan)) != ERR_None)
+          {
+            break; // exit the loop if operation is illegal.
+          }
+        }
+        if((ret == ERR_None) && !v_window.empty())
+        {
+          ret = ERR_IllegalFile; // the file ends in a batch.
+        }
+        fclose(p_file);
+      }
+      if(ret == 0)
+      {
+        __logMsg("\r\n xml tree set value succ.\r\n");
+      }
+      else
+      {
+        __logMsg("\r\n xml tree set value failed, err code: %d\r\n", ret);
+      }
+
+      return ret;
+    }
+
+    /**
+     * @brief This func set batches of value of item by an xml file like
+     *        add_batch_fromXmlFile(), but parses the batches on several
+     *        threads.
+     *
+     * @input str_xml_val: name of value xml file.
+     * @input n_threadNum: number of threads, 0 for the number of cpu cores.
+     *
+     * @ret   return ERR_None if success otherwise return error code.
+     *
+     * @note  (1) The "Batch" elements of file are found like
+     *            add_batch_fromXmlStream(), and split into one range per
+     *            thread. Each thread parses its range into its own
+     *            dictionary of each item (value to bitmap of batches),
+     *            then the dictionaries are merged in order of range, so the
+     *            tree is the same as loaded by add_batch_fromXmlFile().
+     *
+     *        (2) If any batch can not be added (an illegal member, or an
+     *            index used twice), nothing is merged and the file is
+     *            loaded by add_batch_fromXmlFile() instead, so the tree and
+     *            the error code are the same as it too.
+     *
+     *        (3) Threads only see the batches, so the text around them must
+     *            be the root element with blanks and comments only, or the
+     *            file is loaded by add_batch_fromXmlFile() as well, which
+     *            throws on a broken file the same way.
+     */
+    int add_batch_fromXmlFileParallel(const char* str_xml_val, unsigned n_threadNum = 0)
+    {
+      Tree_FileMap_t xml_file;
+      if(!xml_file.map_file(str_xml_val)) return ERR_OpenFile;
+
+      /* find the batches, and split them. */
+      std::vector<std::pair<size_t, size_t> > v_batchRange;
+      size_t n_pos = 0, n_begin, n_end;
+      while(_find_batch(xml_file.data(), xml_file.size(), n_pos, n_begin, n_end))
+      {
+        v_batchRange.push_back(std::make_pair(n_begin, n_end));
+      }
+      if(n_threadNum == 0) n_threadNum = std::max(1u, std::thread::hardware_concurrency());
+      size_t n_partNum = std::min<size_t>(n_threadNum, v_batchRange.size() / C_nMinPartBatch);
+      if((n_partNum > 1) && !_check_batchText(xml_file.data(), xml_file.size(), v_batchRange))
+      {
+        n_partNum = 0; // something else in root, or the root is broken.
+      }
+
+      int ret = ERR_None;
+      if(n_partNum > 1)
+      {
+        std::vector<Tree_Part_t> v_part(n_partNum);
+        std::vector<std::thread> v_thread;
+        for(size_t m = 0; m < n_partNum; m++)
+        {
+          size_t n_first = v_batchRange.size() * m / n_partNum;
+          size_t n_last = v_batchRange.size() * (m + 1) / n_partNum - 1;
+          v_part[m].v_text.assign(xml_file.data() + v_batchRange[n_first].first, xml_file.data() + v_batchRange[n_last].second);
+          v_part[m].v_text.push_back('\0');
+          v_thread.push_back(std::thread([this, &v_part, m](){ _parse_part(v_part[m]); }));
+        }
+        for(size_t m = 0; m < n_partNum; m++)
+        {
+          v_thread[m].join();
+        }
+        if(_check_parts(v_part))
+        {
+          _merge_parts(v_part);
+          __logMsg("\r\n xml tree set value succ, %u batches by %u threads.\r\n", (unsigned)v_batchRange.size(), (unsigned)n_partNum);
+          return ERR_None;
+        }
+      }
+      ret = _add_batches(xml_file.data()); // few batches, or an error to report by loading serially.
+      return ret;
+    }
+
+    /**
+     * @brief This func get the name of one item.
+     *
+     * @input n_itemId: id of item, look "xml_name.xml" for its combination.
+	 *
+	 * @ret   return name of item.
+     */
+    const char* get_itemName(Tree_Id_t n_itemId) const
+    {
+      Tree_Item_t *item = _search_item_byId(n_itemId);
+      if(item != NULL)
+      {
+        if(!item->str_name.empty())
+        {
+          return item->str_name.c_str();
+        }
+      }
+      return NULL;
+    }
+
+    /**
+     * @brief This func get the handle of one item by its name.
+     *
+     * @input str_itemName: name of item.
+     *
+     * @ret   return handle of item, or NULL if the item is not registered.
+     *
+     * @note  (1) the handle is valid until the tree is destroyed.
+     */
+    Tree_Handle_t get_itemHandle(const char* str_itemName) const
+    {
+      return _search_item_byName(str_itemName);
+    }
+
+    /**
+     * @brief This func return the set of batch index.
+     *
+     * @note  (1) User can check this set with the batch index
+     *            in "xml_val.xml", they should be the same.
+     */
+    void get_batchSet(std::set<uint32_t> &set_batch) const
+    {
+      set_batch.clear(); // clear the original element first.
+      bm_batchIndex.for_each([&](uint32_t batch_index){
+        set_batch.insert(set_batch.end(), batch_index); // copy from bm_batchIndex in order.
+      });
+    }
+
+    /**
+     * @brief This func get one batch of value by its index.
+     *
+     * @input n_batchIndex: index of batch.
+     * @output m_batch: map of pair <name, val>.
+	 *
+	 * @ret   return ERR_None if suceess otherwise return error code.
+     *
+     * @note  (1) the val element in m_batch is allocate in this function,
+     *            so remember to free space of it before clear the map.
+     *            The way to free:
+     *            {
+     *              if(val->e_type == VAL_String) delete val->u_val.val_string;
+     *              delete val;
+     *            }
+     */
+    int get_oneBatchValue(uint32_t n_batchIndex, std::map<std::string, Tree_Val_t*> &m_batch) const
+    {
+      if(bm_batchIndex.contains(n_batchIndex))
+      {
+        _get_membersOfBatch(n_batchIndex, m_batch);
+        return ERR_None;
+      }
+      return ERR_UnregisteredIndex;
+    }
+
+    /**
+     * @brief This func get value of once item by its item id.
+     *
+     * @input n_itemId: id of item.
+     * @output m_item: map of pair <batch_index, val>.
+     *
+     * @ret return return ERR_None if success otherwise return error code.
+     *
+     * @note  (1) the val element in m_batch is allocate in this function,
+     *            so remember to free space of it before clear the map.
+     *            The way to free:
+     *            {
+     *              if(val->e_type == VAL_String) delete val->u_val.val_string;
+     *              delete val;
+     *            }
+     */
+    int get_oneItemValue(const char* str_itemName, std::map<uint32_t, Tree_Val_t*> &m_item) const
+    {
+      return get_oneItemValue(_search_item_byName(str_itemName), m_item);
+    }
+
+    /**
+     * @brief This func get value of once item by its handle.
+     *
+     * @input h_item: handle of item, from get_itemHandle().
+     * @output m_item: map of pair <batch_index, val>.
+     *
+     * @ret return return ERR_None if success otherwise return error code.
+     *
+     * @note  (1) free the val element in the same way as above.
+     */
+    int get_oneItemValue(Tree_Handle_t h_item, std::map<uint32_t, Tree_Val_t*> &m_item) const
+    {
+      if(h_item != NULL)
+      {
+        _get_membersOfItem(h_item, m_item);
+        return ERR_None;
+      }
+      return ERR_UnregisteredItem;
+    }
+
+    /**
+     * @brief This func get one batch of value by its index like
+     *        get_oneBatchValue(), but as views of the values in tree.
+     *
+     * @input n_batchIndex: index of batch.
+     * @output v_batch: one view per item with a value in this batch, in
+     *         pre-order of items.
+     *
+     * @ret   return ERR_None if suceess otherwise return error code.
+     *
+     * @note  (1) Nothing is allocated per value, and nothing need to be
+     *            freed. v_batch is cleared first but keeps its capacity, so
+     *            reusing it for the next batch allocates nothing.
+     *
+     *        (2) Views are valid until the tree is changed or destroyed.
+     */
+    int get_oneBatchView(uint32_t n_batchIndex, std::vector<Tree_ItemView_t> &v_batch) const
+    {
+      v_batch.clear();
+      return for_each_in_batch(n_batchIndex, [&](Tree_Handle_t h_item, const Tree_ValView_t &s_val){
+        Tree_ItemView_t s_view = {h_item, h_item->str_name.c_str(), s_val};
+        v_batch.push_back(s_view);
+      });
+    }
+
+    /**
+     * @brief This func get value of once item like get_oneItemValue(), but
+     *        as views of the values in tree.
+     *
+     * @input h_item: handle of item, from get_itemHandle().
+     * @output v_item: one view per batch with a value of this item, in
+     *         order of batch index.
+     *
+     * @ret   return ERR_None if success otherwise return error code.
+     *
+     * @note  (1) Same as get_oneBatchView(), nothing is allocated per value
+     *            and views are valid until the tree is changed.
+     */
+    int get_oneItemView(Tree_Handle_t h_item, std::vector<Tree_BatchView_t> &v_item) const
+    {
+      v_item.clear();
+      int ret = for_each_in_item(h_item, [&](uint32_t batch_index, const Tree_ValView_t &s_val){
+        Tree_BatchView_t s_view = {batch_index, s_val};
+        v_item.push_back(s_view);
+      });
+      if((ret == ERR_None) && (h_item->p_column == NULL)) // values of members are in order of member.
+      {
+        std::sort(v_item.begin(), v_item.end(), [](const Tree_BatchView_t &view_a, const Tree_BatchView_t &view_b){
+          return view_a.n_batchIndex < view_b.n_batchIndex;
+        });
+      }
+      return ret;
+    }
+
+    int get_oneItemView(const char* str_itemName, std::vector<Tree_BatchView_t> &v_item) const
+    {
+      return get_oneItemView(_search_item_byName(str_itemName), v_item);
+    }
+
+    /**
+     * @brief This func call fn(batch_index, s_val) for each value of one
+     *        item, s_val is a Tree_ValView_t, without making any container.
+     *
+     * @input h_item: handle of item, from get_itemHandle().
+     * @input fn: callable as fn(uint32_t, const Tree_ValView_t &).
+     *
+     * @ret   return ERR_None if success otherwise return error code.
+     *
+     * @note  (1) Values of a dense item come in order of batch index, the
+     *            others come member by member, each member in order of batch
+     *            index. Use get_oneItemView() for order of batch index.
+     *
+     *        (2) fn must not change the tree, views are valid inside fn.
+     */
+    template<class Fn>
+    int for_each_in_item(Tree_Handle_t h_item, Fn fn) const
+    {
+      if(h_item != NULL)
+      {
+        _for_eachValOfItem(h_item, [&](uint32_t batch_index, const Tree_Val_t &s_val){
+          fn(batch_index, Tree_ValView_t::make_view(s_val));
+        });
+        return ERR_None;
+      }
+      return ERR_UnregisteredItem;
+    }
+
+    template<class Fn>
+    int for_each_in_item(const char* str_itemName, Fn fn) const
+    {
+      return for_each_in_item(_search_item_byName(str_itemName), fn);
+    }
+
+    /**
+     * @brief This func call fn(h_item, s_val) for each item with a value
+     *        in one batch, in pre-order of items, s_val is a Tree_ValView_t.
+     *
+     * @input n_batchIndex: index of batch.
+     * @input fn: callable as fn(Tree_Handle_t, const Tree_ValView_t &).
+     *
+     * @ret   return ERR_None if success otherwise return error code.
+     */
+    template<class Fn>
+    int for_each_in_batch(uint32_t n_batchIndex, Fn fn) const
+    {
+      if(bm_batchIndex.contains(n_batchIndex))
+      {
+        Tree_Val_t s_val;
+        for(size_t m = 0; m < s_itemTable.v_item.size(); m++)
+        {
+          if(_find_val(s_itemTable.v_item[m], n_batchIndex, s_val))
+          {
+            fn(s_itemTable.v_item[m], Tree_ValView_t::make_view(s_val));
+          }
+        }
+        return ERR_None;
+      }
+      return ERR_UnregisteredIndex;
+    }
+
+    /**
+     * @brief This func find the batches whose value of one item matches
+     *        a predicate, such as "height > 1.70".
+     *
+     * @input h_item: handle of item, from get_itemHandle().
+     * @input s_pred: predicate on value, see Tree_Pred_t.
+     * @output bm_result: bitmap of index of matched batches.
+     *
+     * @ret   return ERR_None if success otherwise return error code.
+     *
+     * @note  (1) Each distinct value of item is checked at most once, and
+     *            the batches holding it are added together, no value is
+     *            copied. Values are kept sorted, so comparisons and prefix
+     *            are two binary searches and a union of the covered members.
+     */
+    int query_oneItem(Tree_Handle_t h_item, const Tree_Pred_t &s_pred, Tree_Bitmap_t &bm_result) const
+    {
+      bm_result.clear();
+      if((h_item != NULL) && (h_item->p_column != NULL))
+      {
+        h_item->p_column->query(s_pred, bm_result);
+        return ERR_None;
+      }
+      if(h_item != NULL)
+      {
+        _for_eachMatchedMember(h_item, s_pred, [&](const Tree_Member_t *member){
+          bm_result.union_with(member->bm_batchIndex);
+        });
+        return ERR_None;
+      }
+      return ERR_UnregisteredItem;
+    }
+
+    int query_oneItem(const char* str_itemName, const Tree_Pred_t &s_pred, Tree_Bitmap_t &bm_result) const
+    {
+      return query_oneItem(_search_item_byName(str_itemName), s_pred, bm_result);
+    }
+
+    /**
+     * @brief This func count the batches whose value of one item matches
+     *        a predicate, like query_oneItem() without making the bitmap.
+     *
+     * @input h_item: handle of item, from get_itemHandle().
+     * @input s_pred: predicate on value, see Tree_Pred_t.
+     * @output n_count: number of matched batches.
+     *
+     * @ret   return ERR_None if success otherwise return error code.
+     */
+    int count_oneItem(Tree_Handle_t h_item, const Tree_Pred_t &s_pred, uint64_t &n_count) const
+    {
+      n_count = 0;
+      if((h_item != NULL) && (h_item->p_column != NULL))
+      {
+        n_count = h_item->p_column->count(s_pred);
+        return ERR_None;
+      }
+      if(h_item != NULL)
+      {
+        _for_eachMatchedMember(h_item, s_pred, [&](const Tree_Member_t *member){
+          n_count += member->bm_batchIndex.cardinality();
+        });
+        return ERR_None;
+      }
+      return ERR_UnregisteredItem;
+    }
+
+    int count_oneItem(const char* str_itemName, const Tree_Pred_t &s_pred, uint64_t &n_count) const
+    {
+      return count_oneItem(_search_item_byName(str_itemName), s_pred, n_count);
+    }
+
+    /**
+     * @brief This func compute count, sum, min, max and average of the
+     *        number values of one item, such as average height.
+     *
+     * @input h_item: handle of item, from get_itemHandle().
+     * @input bm_filter: only count the batches in it, NULL for all.
+     * @output s_stat: statistics, see Tree_Stat_t.
+     *
+     * @ret   return ERR_None if success otherwise return error code.
+     *
+     * @note  (1) Each distinct value is weighted by the number of batches
+     *            holding it, the cost is O(distinct values) plus one
+     *            intersection per value if filtered.
+     *
+     *        (2) Strings and NaN are skipped.
+     */
+    int stat_oneItem(Tree_Handle_t h_item, Tree_Stat_t &s_stat, const Tree_Bitmap_t *bm_filter = NULL) const
+    {
+      memset(&s_stat, 0, sizeof(s_stat));
+      if((h_item != NULL) && (h_item->p_column != NULL))
+      {
+        h_item->p_column->stat(s_stat, bm_filter);
+        return ERR_None;
+      }
+      if(h_item != NULL)
+      {
+        _for_eachNumberMember(h_item, bm_filter, [&](double d_val, uint64_t n_weight){
+          if((s_stat.n_count == 0) || (d_val < s_stat.d_min)) s_stat.d_min = d_val;
+          if((s_stat.n_count == 0) || (d_val > s_stat.d_max)) s_stat.d_max = d_val;
+          s_stat.n_count += n_weight;
+          s_stat.d_sum += d_val * n_weight;
+        });
+        if(s_stat.n_count != 0) s_stat.d_avg = s_stat.d_sum / s_stat.n_count;
+        return ERR_None;
+      }
+      return ERR_UnregisteredItem;
+    }
+
+    int stat_oneItem(const char* str_itemName, Tree_Stat_t &s_stat, const Tree_Bitmap_t *bm_filter = NULL) const
+    {
+      return stat_oneItem(_search_item_byName(str_itemName), s_stat, bm_filter);
+    }
+
+    /**
+     * @brief This func count the number values of one item by buckets.
+     *
+     * @input h_item: handle of item, from get_itemHandle().
+     * @input v_bound: ascending bounds of buckets.
+     * @input bm_filter: only count the batches in it, NULL for all.
+     * @output v_count: v_bound.size() + 1 counts, v_count[i] is the number
+     *         of values in [v_bound[i - 1], v_bound[i]), the first and the
+     *         last buckets are open.
+     *
+     * @ret   return ERR_None if success otherwise return error code.
+     */
+    int histogram_oneItem(Tree_Handle_t h_item, const std::vector<double> &v_bound, std::vector<uint64_t> &v_count, const Tree_Bitmap_t *bm_filter = NULL) const
+    {
+      v_count.assign(v_bound.size() + 1, 0);
+      if(h_item != NULL)
+      {
+        _for_eachNumberMember(h_item, bm_filter, [&](double d_val, uint64_t n_weight){
+          v_count[std::upper_bound(v_bound.begin(), v_bound.end(), d_val) - v_bound.begin()] += n_weight;
+        });
+        return ERR_None;
+      }
+      return ERR_UnregisteredItem;
+    }
+
+    int histogram_oneItem(const char* str_itemName, const std::vector<double> &v_bound, std::vector<uint64_t> &v_count, const Tree_Bitmap_t *bm_filter = NULL) const
+    {
+      return histogram_oneItem(_search_item_byName(str_itemName), v_bound, v_count, bm_filter);
+    }
+
+    /**
+     * @brief This func group the batches by value of key item and compute
+     *        statistics of value item in each group, such as average
+     *        height per class.
+     *
+     * @input h_keyItem: handle of item to group by.
+     * @input h_valItem: handle of item to compute statistics.
+     * @input bm_filter: only count the batches in it, NULL for all.
+     * @output v_group: one group per value of key item with batches.
+     *
+     * @ret   return ERR_None if success otherwise return error code.
+     *
+     * @note  (1) The key item is already dictionary encoded, each member
+     *            is a group. A group looks up the value of each of its
+     *            batches, unless it is large enough for intersecting with
+     *            each member of value item (like stat_oneItem()) to be
+     *            cheaper, which needs a value item of few members. A dense
+     *            key item is grouped by value first.
+     */
+    int group_byItem(Tree_Handle_t h_keyItem, Tree_Handle_t h_valItem, std::vector<Tree_Group_t> &v_group, const Tree_Bitmap_t *bm_filter = NULL) const
+    {
+      v_group.clear();
+      if((h_keyItem == NULL) || (h_valItem == NULL)) return ERR_UnregisteredItem;
+
+      Tree_Bitmap_t bm_group;
+      _for_eachGroup(h_keyItem, [&](const Tree_Val_t &s_key, const Tree_Bitmap_t &bm_key){
+        bm_group = bm_key;
+        if(bm_filter != NULL) bm_group.intersect_with(*bm_filter);
+        if(bm_group.empty()) return;
+
+        Tree_Group_t s_group;
+        s_group.s_key.e_type = s_key.e_type; // copy by member, not copying the string.
+        s_group.s_key.u_val = s_key.u_val;
+        s_group.s_key.n_memLen = s_key.n_memLen;
+        s_group.n_batchNum = bm_group.cardinality();
+        if((h_valItem->p_column != NULL)
+           || ((h_valItem->s_encoding.e_encoding == ENC_Dictionary) && (s_group.n_batchNum < h_valItem->l_member.size() * C_nGroupMemberCost)))
+        {
+          _stat_byBatch(h_valItem, bm_group, s_group.s_stat);
+        }
+        else
+        {
+          stat_oneItem(h_valItem, s_group.s_stat, &bm_group);
+        }
+        v_group.push_back(s_group);
+      });
+      return ERR_None;
+    }
+
+    int group_byItem(const char* str_keyItemName, const char* str_valItemName, std::vector<Tree_Group_t> &v_group, const Tree_Bitmap_t *bm_filter = NULL) const
+    {
+      return group_byItem(_search_item_byName(str_keyItemName), _search_item_byName(str_valItemName), v_group, bm_filter);
+    }
+
+    /**
+     * @brief This func measure the values of each item, and choose how the
+     *        item keeps them, call it after loading the batches.
+     *
+     * @note  (1) Encodings, see Tree_Encoding_e, are tried in order:
+     *            ENC_Run - few distinct values (no more than
+     *                C_nRunMaxMember) over long runs of contiguous batches
+     *                (C_nRunLength on average), such as batches sorted by
+     *                class. Bitmaps of members become runs and the index of
+     *                batch to member is dropped, a value of batch is found
+     *                in the bitmaps.
+     *            ENC_Dense - numbers only, held by fewer than C_nDenseRatio
+     *                batches each on average, with compact batches. Values
+     *                are kept in a column indexed by batch (Tree_Column_t),
+     *                queries and statistics are scans of it.
+     *            ENC_Dictionary - the others, bitmaps are turned into runs
+     *                where it saves memory.
+     *
+     *        (2) Queries work the same on all encodings. Adding batches to a
+     *            run item, or a string to a dense item, turns it back to
+     *            ENC_Dictionary until the next optimize(), numbers added to
+     *            a dense item are put in the column, unless the column
+     *            would span more than C_nDenseSpan slots per value, then it
+     *            is turned back too.
+     */
+    void optimize()
+    {
+      for(size_t m = 0; m < s_itemTable.v_item.size(); m++)
+      {
+        _optimize_item(s_itemTable.v_item[m]);
+      }
+    }
+
+    /**
+     * @brief This func get the encoding of one item, to see what optimize()
+     *        chose and why.
+     *
+     * @input h_item: handle of item, from get_itemHandle().
+     * @output s_encoding: encoding, see Tree_Encoding_t.
+     *
+     * @ret   return ERR_None if success otherwise return error code.
+     */
+    int get_itemEncoding(Tree_Handle_t h_item, Tree_Encoding_t &s_encoding) const
+    {
+      if(h_item != NULL)
+      {
+        s_encoding = h_item->s_encoding;
+        s_encoding.n_memSize = _get_itemMemSize(h_item);
+        return ERR_None;
+      }
+      return ERR_UnregisteredItem;
+    }
+
+    int get_itemEncoding(const char* str_itemName, Tree_Encoding_t &s_encoding) const
+    {
+      return get_itemEncoding(_search_item_byName(str_itemName), s_encoding);
+    }
+
+    /**
+     * @brief This func find the batches matching a query over several
+     *        items, see Tree_Query_t.
+     *
+     * @input s_query: root node of query.
+     * @output bm_result: bitmap of index of matched batches.
+     *
+     * @ret   return ERR_None if success otherwise return error code.
+     *
+     * @note  (1) Childs of AND are evaluated from the most selective one,
+     *            estimated by the number of batches they match, and the
+     *            evaluation stops once the result is empty. NOT under AND
+     *            is subtracted instead of being complemented.
+     */
+    int query_batches(const Tree_Query_t &s_query, Tree_Bitmap_t &bm_result) const
+    {
+      int ret = _check_query(s_query);
+      bm_result.clear();
+      if(ret == ERR_None)
+      {
+        _eval_query(s_query, bm_result);
+      }
+      return ret;
+    }
+
+    /**
+     * @brief This func count the batches matching a query over several
+     *        items, like query_batches() without keeping the bitmap of the
+     *        last child of AND.
+     *
+     * @input s_query: root node of query.
+     * @output n_count: number of matched batches.
+     *
+     * @ret   return ERR_None if success otherwise return error code.
+     */
+    int count_batches(const Tree_Query_t &s_query, uint64_t &n_count) const
+    {
+      int ret = _check_query(s_query);
+      n_count = 0;
+      if(ret == ERR_None)
+      {
+        if(s_query.e_op == QUERY_Pred)
+        {
+          ret = count_oneItem(s_query.h_item, s_query.s_pred, n_count);
+        }
+        else if(s_query.e_op == QUERY_And)
+        {
+          n_count = _eval_andQuery(s_query, NULL);
+        }
+        else
+        {
+          Tree_Bitmap_t bm_result;
+          _eval_query(s_query, bm_result);
+          n_count = bm_result.cardinality();
+        }
+      }
+      return ret;
+    }
+
+    /**
+     * @brief This func delete one batch of value.
+     *
+     * @input n_batchIndex: index of batch.
+     *
+     * @ret   Return ERR_None if the n_batchIndex is legal,
+	 *        return error code otherwise.
+     */
+     int delete_oneBatch(uint32_t n_batchIndex)
+     {
+        if(bm_batchIndex.contains(n_batchIndex))
+        {
+          Tree_Bitmap_t bm_delete;
+          bm_delete.add(n_batchIndex);
+          _delete_batches(bm_delete);
+          return 0;
+        }
+        return ERR_UnregisteredIndex;
+     }
+
+    /**
+     * @brief This func delete several batches of value at once, such as
+     *        the result of query_batches().
+     *
+     * @input bm_batch: bitmap of index of batches.
+     *
+     * @ret   return ERR_None if all batches are in tree, otherwise the
+     *        others are deleted and ERR_UnregisteredIndex is returned.
+     *
+     * @note  (1) Each item is visited once for all the batches, and a large
+     *            delete is done by bitmap operations on members, see
+     *            _delete_membersOfBatch().
+     */
+    int delete_batches(const Tree_Bitmap_t &bm_batch)
+    {
+      Tree_Bitmap_t bm_delete(bm_batch);
+      bm_delete.intersect_with(bm_batchIndex);
+      _delete_batches(bm_delete);
+      return (bm_delete.cardinality() == bm_batch.cardinality()) ? ERR_None : ERR_UnregisteredIndex;
+    }
+
+    int delete_batches(const std::set<uint32_t> &set_batch)
+    {
+      Tree_Bitmap_t bm_batch;
+      for(auto iter = set_batch.begin(); iter != set_batch.end(); ++iter)
+      {
+        bm_batch.add(*iter);
+      }
+      return delete_batches(bm_batch);
+    }
+
+    /**
+     * @brief This func delete the batches of tree whose index is in
+     *        [n_firstIndex, n_lastIndex].
+     *
+     * @ret   return ERR_None, the range needn't be full.
+     */
+    int delete_batches(uint32_t n_firstIndex, uint32_t n_lastIndex)
+    {
+      Tree_Bitmap_t bm_delete;
+      bm_batchIndex.for_each([&](uint32_t batch_index){
+        if((batch_index >= n_firstIndex) && (batch_index <= n_lastIndex)) bm_delete.add(batch_index);
+      });
+      _delete_batches(bm_delete);
+      return ERR_None;
+    }
+
+    /**
+     * @brief This func save the whole tree, items and their values, into
+     *        a binary snapshot file, which load_snapshot() can restore
+     *        much faster than parsing the xml files again.
+     *
+     * @input str_snapshot: name of snapshot file.
+     *
+     * @ret   return ERR_None if success otherwise return error code.
+     *
+     * @note  (1) Format (native byte order, all numbers are uint32_t
+     *            unless noted):
+     *            magic "XTSN", version, FORMAT_Item_Bits, bitmap of batches,
+     *            then items in pre-order, each item is
+     *            { id (uint64), length of name, name with '\0', encoding,
+     *              batches, distinct values and runs (uint64) measured by
+     *              optimize(), number of member, members, number of child }
+     *            and each member is
+     *            { type, value, bitmap of batches },
+     *            where value is int32, double, or length and string with '\0',
+     *            and a bitmap is
+     *            { number of container, containers }
+     *            of Tree_Bitmap_t::for_each_cont(), each container is
+     *            { key << 16 | kind, number of id, n_size, n_size uint16 }.
+     *
+     *        (2) Encodings of items are restored, a dense item is saved as
+     *            members and put back in a column when it is loaded.
+     */
+    int save_snapshot(const char* str_snapshot) const
+    {
+      int ret = ERR_OpenFile;
+
+      FILE *p_file = fopen(str_snapshot, "wb");
+      if(p_file != NULL)
+      {
+        fwrite(C_strSnapshotMagic.c_str(), 1, C_strSnapshotMagic.length(), p_file);
+        _write_snapshotNum(p_file, C_nSnapshotVersion);
+        _write_snapshotNum(p_file, C_nCrorNum);
+        _write_snapshotBitmap(p_file, bm_batchIndex);
+        _write_snapshotItem(p_file, &s_rootItem);
+
+        ret = ferror(p_file) ? ERR_OpenFile : ERR_None;
+        if(fclose(p_file) != 0) ret = ERR_OpenFile;
+      }
+      if(ret == ERR_None)
+      {
+        __logMsg("\r\n xml tree save snapshot succ.\r\n");
+      }
+      else
+      {
+        __logMsg("\r\n xml tree save snapshot fail, err code: %d\r\n", ret);
+      }
+
+      return ret;
+    }
+
+    /**
+     * @brief This func restore the tree from a snapshot file made by
+     *        save_snapshot(), instead of build_tree_fromXmlFile() and
+     *        add_batch_fromXmlFile().
+     *
+     * @input str_snapshot: name of snapshot file.
+     *
+     * @ret   return ERR_None if success otherwise return error code.
+     *
+     * @note  (1) The tree must be empty, or ERR_UsedTree is returned.
+     *
+     *        (2) The file is mapped and kept until the tree is destroyed,
+     *            string values point into it instead of being copied.
+     */
+    int load_snapshot(const char* str_snapshot)
+    {
+      int ret = ERR_UsedTree;
+
+      if((s_itemTable.v_item.size() == 1) && bm_batchIndex.empty())
+      {
+        ret = ERR_OpenFile;
+        Tree_FileMap_t *snapshot_file = new Tree_FileMap_t;
+        if(snapshot_file->map_file(str_snapshot))
+        {
+          ret = ERR_IllegalFile;
+          const char *p_cur = snapshot_file->data();
+          const char *p_end = p_cur + snapshot_file->size();
+          char str_magic[4] = {0};
+          uint32_t n_version = 0, n_idBits = 0;
+          if(_read_snapshot(p_cur, p_end, str_magic, sizeof(str_magic))
+             && !memcmp(str_magic, C_strSnapshotMagic.c_str(), sizeof(str_magic))
+             && _read_snapshot(p_cur, p_end, &n_version, sizeof(n_version))
+             && (n_version == C_nSnapshotVersion)
+             && _read_snapshot(p_cur, p_end, &n_idBits, sizeof(n_idBits))
+             && (n_idBits == static_cast<uint32_t>(C_nCrorNum)) // ids are made with the same bits.
+             && _read_snapshotBitmap(p_cur, p_end, bm_batchIndex)
+             && _read_snapshotItem(p_cur, p_end, &s_rootItem))
+          {
+            ret = ERR_None;
+          }
+          l_fileMap.push_back(snapshot_file); // members may point into it even if failed.
+          if(ret != ERR_None) // drop the part already restored.
+          {
+            _free_itemTree();
+            bm_batchIndex.clear();
+          }
+        }
+        else
+        {
+          delete snapshot_file;
+        }
+      }
+      if(ret == ERR_None)
+      {
+        __logMsg("\r\n xml tree load snapshot succ.\r\n");
+      }
+      else
+      {
+        __logMsg("\r\n xml tree load snapshot fail, err code: %d\r\n", ret);
+      }
+
+      return ret;
+    }
+
+  private:
+
+    /**
+     * @note no copying!
+     */
+    xmlTree(const xmlTree &);
+    void operator =(const xmlTree &);
+
+    friend class xmlSharedTree;
+
+    /**
+     * @note  Members, their strings and the nodes of containers in items
+     *        are all allocated in the arena of tree.
+     */
+    struct Tree_Member_t;
+    typedef std::list<Tree_Member_t *, Tree_PoolAlloc_t<Tree_Member_t *> > Tree_MemberList_t;
+
+    struct Tree_Member_t
+    {
+      Tree_Val_t s_val;                               // Struct of value of member, a string points into s_strPool.
+      uint32_t n_strId;                               // Id of string in s_strPool, for VAL_String.
+      Tree_Bitmap_t bm_batchIndex;                    // Bitmap of index of batch that this member is in.
+      Tree_MemberList_t::iterator iter_member;        // Position in l_member of its item, to erase it without a scan.
+
+      Tree_Member_t(Tree_Arena_t *arena) : n_strId(Tree_StrPool_t::C_nNoStr), bm_batchIndex(arena) {}
+    };
+
+    /**
+     * @note  Hash and compare the value which a member stores by pointer,
+     *        so the dictionary of item can be keyed on the member's own
+     *        value without copying it.
+     */
+    struct Tree_ValHash_t
+    {
+      size_t operator ()(const Tree_Val_t *val) const
+      {
+        switch(val->e_type)
+        {
+        case VAL_String:
+          {
+            size_t hash = 2166136261u; // FNV-1a.
+            for(int m = 0; m < val->n_memLen; m++)
+            {
+              hash = (hash ^ static_cast<unsigned char>(val->u_val.val_string[m])) * 16777619u;
+            }
+            return hash;
+          }
+        case VAL_Int:
+          return std::hash<int>()(val->u_val.val_int);
+        case VAL_Double:
+          return std::hash<double>()(val->u_val.val_double);
+        default:
+          return 0;
+        }
+      }
+    };
+
+    struct Tree_ValEqual_t
+    {
+      bool operator ()(const Tree_Val_t *val_a, const Tree_Val_t *val_b) const
+      {
+        return (val_a == val_b) || ((*val_a) == (*val_b)); // a NaN member is still found by its own value when erased.
+      }
+    };
+
+    /**
+     * @note  Strings of members are interned in s_strPool, so the same
+     *        string is at the same address in the whole tree, and is
+     *        hashed and compared by its address.
+     */
+    struct Tree_MemberHash_t
+    {
+      size_t operator ()(const Tree_Val_t *val) const
+      {
+        if(val->e_type == VAL_String)
+        {
+          return std::hash<const void *>()(val->u_val.val_string);
+        }
+        return Tree_ValHash_t()(val);
+      }
+    };
+
+    struct Tree_MemberEqual_t
+    {
+      bool operator ()(const Tree_Val_t *val_a, const Tree_Val_t *val_b) const
+      {
+        if((val_a->e_type == VAL_String) && (val_b->e_type == VAL_String))
+        {
+          return val_a->u_val.val_string == val_b->u_val.val_string;
+        }
+        return Tree_ValEqual_t()(val_a, val_b);
+      }
+    };
+
+    typedef std::unordered_map<const Tree_Val_t *, Tree_Member_t *, Tree_MemberHash_t, Tree_MemberEqual_t,
+                               Tree_PoolAlloc_t<std::pair<const Tree_Val_t * const, Tree_Member_t *> > > Tree_MemberDict_t;
+    typedef std::unordered_map<uint32_t, Tree_Member_t *, std::hash<uint32_t>, std::equal_to<uint32_t>,
+                               Tree_PoolAlloc_t<std::pair<const uint32_t, Tree_Member_t *> > > Tree_BatchMemberMap_t;
+
+    /**
+     * @note  Hash and compare the name of item as c string, so the name
+     *        read from xml file can be looked up without a std::string.
+     */
+    struct Tree_StrHash_t
+    {
+      size_t operator ()(const char *str) const
+      {
+        size_t hash = 2166136261u; // FNV-1a.
+        for( ; (*str) != '\0'; str++)
+        {
+          hash = (hash ^ static_cast<unsigned char>(*str)) * 16777619u;
+        }
+        return hash;
+      }
+    };
+
+    struct Tree_StrEqual_t
+    {
+      bool operator ()(const char *str_a, const char *str_b) const
+      {
+        return !strcmp(str_a, str_b);
+      }
+    };
+
+    /**
+     * @note  Items are allocated in the arena of tree in pre-order, and
+     *        linked by s_itemTable, not by pointers of their own.
+     */
+    struct Tree_Item_t
+    {
+      uint32_t n_pos;                                 // Index of item in s_itemTable.
+      std::string str_name;                           // Name of item.
+
+      Tree_MemberList_t l_member;                       // List of member of item.
+      Tree_MemberDict_t um_member;                      // Dictionary from value to member, keyed on member's own value.
+      Tree_BatchMemberMap_t um_batchMember;             // Map from batch index to the member holding its value.
+      mutable std::vector<Tree_Member_t *> v_sortedMember; // Members sorted by value, rebuilt for range query when is_sorted is false.
+      mutable bool is_sorted;                           // v_sortedMember matches l_member.
+      Tree_Column_t *p_column;                          // Dense column used instead of members, NULL if the item uses members.
+      Tree_Encoding_t s_encoding;                       // Encoding in use, and the values measured to choose it.
+
+      Tree_Item_t(Tree_Arena_t *arena)
+        : n_pos(0), l_member(arena),
+          um_member(0, Tree_MemberHash_t(), Tree_MemberEqual_t(), arena),
+          um_batchMember(0, std::hash<uint32_t>(), std::equal_to<uint32_t>(), arena),
+          is_sorted(false), p_column(NULL)
+      {
+        memset(&s_encoding, 0, sizeof(s_encoding));
+      }
+    };
+
+    /**
+     * @brief Table of items of tree in pre-order, struct of arrays indexed
+     *        by n_pos of item, v_item[0] is the root item.
+     *
+     * @note  (1) Walks over the whole tree are loops over the table, a parent
+     *            is always before its childs. Links are indexes of table,
+     *            C_nNoItem for none.
+     */
+    struct Tree_ItemTable_t
+    {
+      std::vector<Tree_Item_t *> v_item;                // Items.
+      std::vector<uint32_t> v_parent;                   // Index of parent.
+      std::vector<uint32_t> v_firstChild;               // Index of first child.
+      std::vector<uint32_t> v_nextSibling;              // Index of next sibling.
+      std::vector<Tree_Id_t> v_id;                      // Id of item, see Tree_Id_t.
+      std::vector<const char *> v_name;                 // Name of item, points to str_name of item.
+
+      void clear()
+      {
+        v_item.clear();
+        v_parent.clear();
+        v_firstChild.clear();
+        v_nextSibling.clear();
+        v_id.clear();
+        v_name.clear();
+      }
+    };
+
+    /**
+     * @note  Dictionary of one item made by a thread of parallel loading,
+     *        values point into the text of its part.
+     */
+    struct Tree_PartItem_t
+    {
+      struct Tree_PartMember_t
+      {
+        Tree_Val_t s_val;                               // Value.
+        Tree_Bitmap_t bm_batchIndex;                    // Batches of the value in this part.
+      };
+      typedef std::unordered_map<const Tree_Val_t *, Tree_PartMember_t *, Tree_ValHash_t, Tree_ValEqual_t> Tree_PartDict_t;
+
+      std::deque<Tree_PartMember_t> dq_member;          // Members in order of first appearance, never moved.
+      Tree_PartDict_t um_member;                        // Dictionary from value to member.
+      Tree_Bitmap_t bm_batchIndex;                      // All batches of item in this part.
+    };
+
+    /**
+     * @note  A range of batches loaded by one thread of parallel loading.
+     */
+    struct Tree_Part_t
+    {
+      std::vector<char> v_text;                         // Text of the batches, parsed in place.
+      std::vector<Tree_Item_t *> v_item;                // Items in order of first appearance.
+      std::unordered_map<const Tree_Item_t *, Tree_PartItem_t> um_item; // Dictionary of each item.
+      std::vector<uint32_t> v_batchIndex;               // Index of batches in order.
+      bool is_valid;                                    // All batches can be added.
+
+      Tree_Part_t() : is_valid(false) {}
+    };
+
+    /**
+     * @brief Plan of ingest learned from the first batch of a file, the
+     *        item and type of the member at each position.
+     *
+     * @note  (1) Batches of a file usually have the same members in the
+     *            same order, so a member whose name and type text are the
+     *            same as at its position in the first batch takes item and
+     *            type from the plan, without searching the item by name.
+     *
+     *        (2) A member deviating from the plan is resolved in full.
+     */
+    struct Tree_BatchPlan_t
+    {
+      struct Tree_PlanMember_t
+      {
+        std::string str_name;                           // Name of member.
+        Tree_Item_t *p_item;                            // Item of member, with legal id.
+        std::string str_type;                           // Text of type of member.
+        Tree_Val_e e_type;                              // Type of member.
+      };
+
+      std::vector<Tree_PlanMember_t> v_member;          // Members of the first batch in order.
+      bool is_learned;                                  // The first batch is done, the plan is not changed any more.
+
+      Tree_BatchPlan_t() : is_learned(false) {}
+    };
+
+    /**
+     * @ret Return ERR_None if build item tree succeed, otherwise return error code.
+     *      Conditions to succeed:
+     *      (1) all sub layers return 0. (ret |= _make_itemTree())
+     *      (2) all item in this layer is legal.
+     *          ((cnt_item != 0) && (cnt_item == cnt_legalItem))
+     *      Or
+     *      (1) in last layer directly return 0.
+     *          ((node_parent->first_node() == NULL) && (n_layer > 0))
+     */
+    int _make_itemTree(const rapidxml::xml_node<>* node_parent, Tree_Item_t *item_parent, int n_layer)
+    {
+      int ret = ERR_NullPointer;
+
+      if((node_parent != NULL) && (item_parent != NULL)) // node and item is not null.
+      {
+        ret = ERR_OverLayer;
+        if(n_layer < C_nMaxLayer) // the layer number can not >= C_nMaxLayer.
+        {
+          if((node_parent->first_node() == NULL) && (n_layer > 0)) return ERR_None; // the last layer directly return ERR_None.
+
+          ret = ERR_NoXmlNode;
+          int last_err = ERR_None;
+          int cnt_item = 0, cnt_legalItem = 0;
+          std::set<uint32_t> index_set;
+          uint32_t n_prevChild = _get_lastChild(item_parent->n_pos);
+          rapidxml::xml_node<>* child_node = node_parent->first_node(C_strItemTag.c_str());
+          for( ; child_node != NULL; cnt_item++, child_node = child_node->next_sibling(C_strItemTag.c_str())) // should have item node.
+          {
+            if(cnt_item > C_nMaxItem) //should contain fewer than C_nMaxItem items.
+            {
+              ret = ERR_OverItem;
+              break;
+            }
+            ret = ERR_NoXmlAttr;
+            char *p_char;
+            rapidxml::xml_attribute<>* temp_attr = child_node->first_attribute(C_strIndexTag.c_str());
+            if(temp_attr != NULL) // should have item layer index attribute.
+            {
+              ret = ERR_IllegalIndex;
+              uint32_t item_index = static_cast<uint32_t>(strtol(temp_attr->value(), &p_char, 10));
+              if((item_index != 0) && (item_index <= C_nMaxItem) && (index_set.find(item_index) == index_set.end())) // item index is legal and not used.
+              {
+                Tree_Item_t *child_item = _new_item();
+                Tree_Id_t child_id = (static_cast<Tree_Id_t>(item_index) << (C_nCrorNum * n_layer)) | s_itemTable.v_id[item_parent->n_pos];
+                child_item->str_name = child_node->first_attribute(C_strNameTag.c_str())->value();
+                n_prevChild = _add_itemToTable(child_item, item_parent->n_pos, n_prevChild, child_id); // put the item after its parent and elder siblings.
+                um_itemName.insert(std::make_pair(child_item->str_name.c_str(), child_item)); // index the item by name, first one wins.
+                um_itemId[child_id] = child_item;
+                __logMsg("add item: name(%s) id(%08llx)\r\n",child_item->str_name.c_str(), static_cast<unsigned long long>(child_id));
+
+                index_set.insert(item_index);
+                cnt_legalItem ++;
+                last_err |= _make_itemTree(child_node, child_item, n_layer+1);
+              }
+            }
+          }
+          index_set.clear();
+          if((cnt_item != 0) && (cnt_item == cnt_legalItem))
+          {
+            ret = last_err;
+          }
+          else
+          {
+            ret = ret;
+          }
+        }
+      }
+      return ret;
+    }
+
+    /**
+     * @brief This func free the values of all items and the items except
+     *        root, from the last item of table to the first.
+     */
+    void _free_itemTree()
+    {
+      for(size_t m = s_itemTable.v_item.size(); m-- > 0; )
+      {
+        Tree_Item_t *item_cur = s_itemTable.v_item[m];
+        /* free the space of value, unless the whole arena is freed. */
+        if(!s_arena.get_releasing())
+        {
+          for(auto iter = item_cur->l_member.begin(); iter != item_cur->l_member.end(); ++iter)
+          {
+            _delete_member(*iter);
+          }
+        }
+        item_cur->l_member.clear();
+        item_cur->um_member.clear();
+        item_cur->um_batchMember.clear();
+        item_cur->v_sortedMember.clear();
+        item_cur->is_sorted = false;
+        delete item_cur->p_column;
+        item_cur->p_column = NULL;
+        memset(&item_cur->s_encoding, 0, sizeof(item_cur->s_encoding));
+
+        /* free the space of item, root item is not allocated. */
+        if(item_cur != &s_rootItem)
+        {
+          item_cur->~Tree_Item_t();
+          s_arena.deallocate(item_cur, sizeof(Tree_Item_t));
+        }
+      }
+      um_itemName.clear();
+      um_itemId.clear();
+      s_itemTable.clear();
+      _add_itemToTable(&s_rootItem, C_nNoItem, C_nNoItem, 0);
+    }
+
+    Tree_Item_t *_new_item()
+    {
+      return new(s_arena.allocate(sizeof(Tree_Item_t))) Tree_Item_t(&s_arena);
+    }
+
+    /**
+     * @brief This func append an item to s_itemTable, as the next sibling
+     *        of n_prevSibling, or the first child of n_parent if it is
+     *        C_nNoItem.
+     *
+     * @ret   return index of item.
+     */
+    uint32_t _add_itemToTable(Tree_Item_t *item_cur, uint32_t n_parent, uint32_t n_prevSibling, Tree_Id_t n_id)
+    {
+      item_cur->n_pos = static_cast<uint32_t>(s_itemTable.v_item.size());
+      s_itemTable.v_item.push_back(item_cur);
+      s_itemTable.v_parent.push_back(n_parent);
+      s_itemTable.v_firstChild.push_back(C_nNoItem);
+      s_itemTable.v_nextSibling.push_back(C_nNoItem);
+      s_itemTable.v_id.push_back(n_id);
+      s_itemTable.v_name.push_back(item_cur->str_name.c_str());
+      if(n_prevSibling != C_nNoItem)
+      {
+        s_itemTable.v_nextSibling[n_prevSibling] = item_cur->n_pos;
+      }
+      else if(n_parent != C_nNoItem)
+      {
+        s_itemTable.v_firstChild[n_parent] = item_cur->n_pos;
+      }
+      return item_cur->n_pos;
+    }
+
+    /**
+     * @ret return index of last child of item, C_nNoItem if none.
+     */
+    uint32_t _get_lastChild(uint32_t n_parent) const
+    {
+      uint32_t n_child = s_itemTable.v_firstChild[n_parent];
+      while((n_child != C_nNoItem) && (s_itemTable.v_nextSibling[n_child] != C_nNoItem))
+      {
+        n_child = s_itemTable.v_nextSibling[n_child];
+      }
+      return n_child;
+    }
+
+    void _write_snapshotNum(FILE *p_file, uint32_t n_num) const
+    {
+      fwrite(&n_num, sizeof(n_num), 1, p_file);
+    }
+
+    void _write_snapshotItem(FILE *p_file, const Tree_Item_t *item_cur) const
+    {
+      fwrite(&s_itemTable.v_id[item_cur->n_pos], sizeof(Tree_Id_t), 1, p_file);
+      _write_snapshotNum(p_file, item_cur->str_name.length() + 1);
+      fwrite(item_cur->str_name.c_str(), 1, item_cur->str_name.length() + 1, p_file);
+      const Tree_Encoding_t &s_encoding = item_cur->s_encoding;
+      _write_snapshotNum(p_file, s_encoding.e_encoding);
+      fwrite(&s_encoding.n_batchNum, sizeof(s_encoding.n_batchNum), 1, p_file);
+      fwrite(&s_encoding.n_distinctNum, sizeof(s_encoding.n_distinctNum), 1, p_file);
+      fwrite(&s_encoding.n_runNum, sizeof(s_encoding.n_runNum), 1, p_file);
+
+      /* a dense item is saved as members, it is put back in a column when loaded. */
+      uint32_t n_memberNum = 0;
+      _for_eachGroup(item_cur, [&](const Tree_Val_t &, const Tree_Bitmap_t &){ n_memberNum++; });
+      _write_snapshotNum(p_file, n_memberNum);
+      _for_eachGroup(item_cur, [&](const Tree_Val_t &s_val, const Tree_Bitmap_t &bm_batch){
+        _write_snapshotNum(p_file, s_val.e_type);
+        switch(s_val.e_type)
+        {
+        case VAL_String:
+          _write_snapshotNum(p_file, s_val.n_memLen);
+          fwrite(s_val.u_val.val_string, 1, s_val.n_memLen, p_file);
+          break;
+        case VAL_Int:
+          fwrite(&s_val.u_val.val_int, sizeof(s_val.u_val.val_int), 1, p_file);
+          break;
+        case VAL_Double:
+          fwrite(&s_val.u_val.val_double, sizeof(s_val.u_val.val_double), 1, p_file);
+          break;
+        default:
+          break;
+        }
+        _write_snapshotBitmap(p_file, bm_batch);
+      });
+
+      uint32_t n_childNum = 0;
+      for(uint32_t n_child = s_itemTable.v_firstChild[item_cur->n_pos]; n_child != C_nNoItem; n_child = s_itemTable.v_nextSibling[n_child])
+      {
+        n_childNum++;
+      }
+      _write_snapshotNum(p_file, n_childNum);
+      for(uint32_t n_child = s_itemTable.v_firstChild[item_cur->n_pos]; n_child != C_nNoItem; n_child = s_itemTable.v_nextSibling[n_child])
+      {
+        _write_snapshotItem(p_file, s_itemTable.v_item[n_child]);
+      }
+    }
+
+    void _write_snapshotBitmap(FILE *p_file, const Tree_Bitmap_t &bm_batch) const
+    {
+      uint32_t n_contNum = 0;
+      bm_batch.for_each_cont([&](uint16_t, uint16_t, uint32_t, const uint16_t *, uint32_t){ n_contNum++; });
+      _write_snapshotNum(p_file, n_contNum);
+      bm_batch.for_each_cont([&](uint16_t n_key, uint16_t n_kind, uint32_t n_card, const uint16_t *p_data, uint32_t n_size){
+        _write_snapshotNum(p_file, (static_cast<uint32_t>(n_key) << 16) | n_kind);
+        _write_snapshotNum(p_file, n_card);
+        _write_snapshotNum(p_file, n_size);
+        fwrite(p_data, sizeof(uint16_t), n_size, p_file);
+      });
+    }
+
+    /**
+     * @ret return true and move p_cur forward if n_size bytes are left, false otherwise.
+     */
+    bool _read_snapshot(const char *&p_cur, const char *p_end, void *p_out, size_t n_size) const
+    {
+      if(static_cast<size_t>(p_end - p_cur) >= n_size)
+      {
+        memcpy(p_out, p_cur, n_size); // the numbers in file may not be aligned.
+        p_cur += n_size;
+        return true;
+      }
+      return false;
+    }
+
+    /**
+     * @ret return true if the containers of bitmap are restored, false if the file is broken.
+     */
+    bool _read_snapshotBitmap(const char *&p_cur, const char *p_end, Tree_Bitmap_t &bm_batch) const
+    {
+      uint32_t n_contNum, n_keyKind, n_card, n_size;
+      if(!_read_snapshot(p_cur, p_end, &n_contNum, sizeof(n_contNum))) return false;
+      for(uint32_t m = 0; m < n_contNum; m++)
+      {
+        if(!_read_snapshot(p_cur, p_end, &n_keyKind, sizeof(n_keyKind))
+           || !_read_snapshot(p_cur, p_end, &n_card, sizeof(n_card))
+           || !_read_snapshot(p_cur, p_end, &n_size, sizeof(n_size))
+           || (static_cast<size_t>(p_end - p_cur) / sizeof(uint16_t) < n_size)
+           || !bm_batch.append_cont(static_cast<uint16_t>(n_keyKind >> 16), static_cast<uint16_t>(n_keyKind & 0xffff), n_card, p_cur, n_size))
+        {
+          return false;
+        }
+        p_cur += n_size * sizeof(uint16_t);
+      }
+      return true;
+    }
+
+    /**
+     * @ret return true if the item and its childs are restored, false if the file is broken.
+     */
+    bool _read_snapshotItem(const char *&p_cur, const char *p_end, Tree_Item_t *item_cur)
+    {
+      uint32_t n_len, n_num;
+      Tree_Id_t &n_id = s_itemTable.v_id[item_cur->n_pos];
+      if(!_read_snapshot(p_cur, p_end, &n_id, sizeof(n_id))
+         || !_read_snapshot(p_cur, p_end, &n_len, sizeof(n_len))
+         || (n_len == 0) || (static_cast<size_t>(p_end - p_cur) < n_len) || (p_cur[n_len - 1] != '\0'))
+      {
+        return false;
+      }
+      item_cur->str_name.assign(p_cur, n_len - 1);
+      s_itemTable.v_name[item_cur->n_pos] = item_cur->str_name.c_str();
+      p_cur += n_len;
+      if(item_cur != &s_rootItem)
+      {
+        um_itemName.insert(std::make_pair(item_cur->str_name.c_str(), item_cur));
+        um_itemId[n_id] = item_cur;
+      }
+
+      uint32_t n_encoding;
+      Tree_Encoding_t &s_encoding = item_cur->s_encoding;
+      if(!_read_snapshot(p_cur, p_end, &n_encoding, sizeof(n_encoding)) || (n_encoding > ENC_Run)
+         || !_read_snapshot(p_cur, p_end, &s_encoding.n_batchNum, sizeof(s_encoding.n_batchNum))
+         || !_read_snapshot(p_cur, p_end, &s_encoding.n_distinctNum, sizeof(s_encoding.n_distinctNum))
+         || !_read_snapshot(p_cur, p_end, &s_encoding.n_runNum, sizeof(s_encoding.n_runNum)))
+      {
+        return false;
+      }
+
+      bool is_number = true;
+      uint32_t n_min = 0xffffffff, n_max = 0;
+      uint64_t n_batchNum = 0;
+      if(!_read_snapshot(p_cur, p_end, &n_num, sizeof(n_num))) return false;
+      for(uint32_t m = 0; m < n_num; m++)
+      {
+        uint32_t n_type;
+        if(!_read_snapshot(p_cur, p_end, &n_type, sizeof(n_type)) || (n_type == VAL_None) || (n_type >= VAL_NUM)) return false;
+
+        Tree_Member_t *member = _new_member();
+        member->s_val.e_type = static_cast<Tree_Val_e>(n_type);
+        member->iter_member = item_cur->l_member.insert(item_cur->l_member.end(), member); // freed with the item if file is broken.
+        switch(member->s_val.e_type)
+        {
+        case VAL_String:
+          if(!_read_snapshot(p_cur, p_end, &n_len, sizeof(n_len))
+             || (n_len == 0) || (static_cast<size_t>(p_end - p_cur) < n_len) || (p_cur[n_len - 1] != '\0'))
+          {
+            return false;
+          }
+          member->s_val.n_memLen = n_len;
+          member->n_strId = s_strPool.intern(p_cur, n_len, true); // borrow the string of mapped file.
+          member->s_val.u_val.val_string = const_cast<char *>(s_strPool.get_string(member->n_strId));
+          p_cur += n_len;
+          break;
+        case VAL_Int:
+          if(!_read_snapshot(p_cur, p_end, &member->s_val.u_val.val_int, sizeof(member->s_val.u_val.val_int))) return false;
+          break;
+        default:
+          if(!_read_snapshot(p_cur, p_end, &member->s_val.u_val.val_double, sizeof(member->s_val.u_val.val_double))) return false;
+          break;
+        }
+        if(!item_cur->um_member.insert(std::make_pair(&member->s_val, member)).second) return false; // values are unique in item.
+        item_cur->is_sorted = false;
+        is_number = is_number && (member->s_val.e_type != VAL_String);
+
+        if(!_read_snapshotBitmap(p_cur, p_end, member->bm_batchIndex)) return false;
+        if(n_encoding == ENC_Dictionary) // other encodings have no index of batch.
+        {
+          member->bm_batchIndex.for_each([&](uint32_t batch_index){
+            item_cur->um_batchMember[batch_index] = member;
+          });
+        }
+        else if(n_encoding == ENC_Dense)
+        {
+          member->bm_batchIndex.for_each([&](uint32_t batch_index){
+            n_min = std::min(n_min, batch_index);
+            n_max = std::max(n_max, batch_index);
+          });
+          n_batchNum += member->bm_batchIndex.cardinality();
+        }
+      }
+      if(n_encoding == ENC_Dense)
+      {
+        if(!is_number) return false;
+        if((n_batchNum == 0) || (static_cast<uint64_t>(n_max - n_min) + 1 <= C_nDenseSpan * (n_batchNum + 1)))
+        {
+          _encode_dense(item_cur);
+        }
+        else // batches were deleted since optimize(), too sparse for a column now.
+        {
+          for(auto iter = item_cur->l_member.begin(); iter != item_cur->l_member.end(); ++iter)
+          {
+            Tree_Member_t *member = (*iter);
+            member->bm_batchIndex.for_each([&](uint32_t batch_index){
+              item_cur->um_batchMember[batch_index] = member;
+            });
+          }
+        }
+      }
+      else if(n_encoding == ENC_Run)
+      {
+        _encode_run(item_cur);
+      }
+
+      if(!_read_snapshot(p_cur, p_end, &n_num, sizeof(n_num))) return false;
+      uint32_t n_prevChild = C_nNoItem;
+      for(uint32_t m = 0; m < n_num; m++)
+      {
+        Tree_Item_t *child_item = _new_item();
+        n_prevChild = _add_itemToTable(child_item, item_cur->n_pos, n_prevChild, 0); // freed with the tree if file is broken.
+        if(!_read_snapshotItem(p_cur, p_end, child_item)) return false;
+      }
+      return true;
+    }
+
+    Tree_Member_t *_new_member()
+    {
+      return new(s_arena.allocate(sizeof(Tree_Member_t))) Tree_Member_t(&s_arena);
+    }
+
+    void _delete_member(Tree_Member_t *member)
+    {
+      if(member->n_strId != Tree_StrPool_t::C_nNoStr)
+      {
+        s_strPool.release(member->n_strId);
+      }
+      member->~Tree_Member_t();
+      s_arena.deallocate(member, sizeof(Tree_Member_t));
+    }
+
+    Tree_Item_t *_search_item_byId(Tree_Id_t n_id) const
+    {
+      if(n_id == 0) return const_cast<Tree_Item_t *>(&s_rootItem);
+
+      auto iter = um_itemId.find(n_id);
+      if(iter != um_itemId.end())
+      {
+        return iter->second;
+      }
+      return NULL;
+    }
+
+    Tree_Item_t* _search_item_byName(const char* str_itemName) const
+    {
+      if(str_itemName != NULL)
+      {
+        auto iter = um_itemName.find(str_itemName);
+        if(iter != um_itemName.end())
+        {
+          return iter->second;
+        }
+      }
+      return NULL;
+    }
+
+    Tree_Id_t _get_parentId(Tree_Id_t id_child) const
+    {
+      int cror = 0; // layers below the top one of id_child.
+      for(Tree_Id_t temp_id = id_child >> C_nCrorNum; temp_id != 0; temp_id >>= C_nCrorNum)
+      {
+        cror++;
+      }
+      return id_child & ((static_cast<Tree_Id_t>(1) << (C_nCrorNum * cror)) - 1); // clear the index of top layer.
+    }
+
+    int _build_tree(char* p_text)
+    {
+      int ret = ERR_None;
+
+      rapidxml::xml_document<> xml_doc;
+      xml_doc.parse<0>(p_text);
+
+      rapidxml::xml_node<>* root_node = xml_doc.first_node();
+      ret = _make_itemTree(root_node, &s_rootItem, 0);
+      if(ret == ERR_None)
+      {
+        __logMsg("\r\n xml tree build succ.\r\n");
+      }
+      else
+      {
+        __logMsg("\r\n xml tree build fail, err code: %d\r\n", ret);
+      }
+
+      return ret;
+    }
+
+    int _add_batches(char* p_text)
+    {
+      int ret = ERR_None;
+
+      rapidxml::xml_document<> xml_doc;
+      xml_doc.parse<0>(p_text);
+
+      rapidxml::xml_node<>* root_node = xml_doc.first_node();
+      Tree_BatchPlan_t s_plan;
+      /* use a loop to get all bathes of value in xml file. */
+      rapidxml::xml_node<>* batch_node = root_node->first_node(C_strBatchTag.c_str());
+      for( ; batch_node != NULL; batch_node = batch_node->next_sibling(C_strBatchTag.c_str()))
+      {
+        if((ret = _add_batch(batch_node, s_plan)) != ERR_None)
+        {
+          break; // exit the loop if operation is illegal.
+        }
+      }
+      if(ret == 0)
+      {
+        __logMsg("\r\n xml tree set value succ.\r\n");
+      }
+      else
+      {
+        __logMsg("\r\n xml tree set value failed, err code: %d\r\n", ret);
+      }
+
+      return ret;
+    }
+
+    /**
+     * @brief This func find the next "Batch" element from n_pos in p_text,
+     *        skipping comments, like _read_batchFromStream().
+     *
+     * @output n_begin, n_end: the element is [n_begin, n_end) of p_text.
+     *
+     * @ret   return true if one batch is found, false at the end of text.
+     */
+    bool _find_batch(const char *p_text, size_t n_size, size_t &n_pos, size_t &n_begin, size_t &n_end) const
+    {
+      const std::string str_open = "<" + C_strBatchTag;
+      const std::string str_close = "</" + C_strBatchTag + ">";
+
+      while((n_pos = _find_inText(p_text, n_size, n_pos, "<")) != std::string::npos)
+      {
+        if(!strncmp(p_text + n_pos, "<!--", std::min<size_t>(4, n_size - n_pos))) // skip the comment.
+        {
+          n_pos = _find_inText(p_text, n_size, n_pos + 4, "-->");
+          if(n_pos == std::string::npos) break;
+          n_pos += 3;
+        }
+        else if((n_size - n_pos > str_open.length()) && !memcmp(p_text + n_pos, str_open.c_str(), str_open.length())
+                && (p_text[n_pos + str_open.length()] != '\0')
+                && (strchr(" \t\r\n/>", p_text[n_pos + str_open.length()]) != NULL)) // start of batch.
+        {
+          size_t n_close = _find_inText(p_text, n_size, n_pos, ">");
+          if((n_close != std::string::npos) && (p_text[n_close - 1] != '/')) // not an empty element, find the close tag.
+          {
+            n_close = _find_inText(p_text, n_size, n_close, str_close.c_str());
+            if(n_close != std::string::npos) n_close += str_close.length() - 1;
+          }
+          if(n_close == std::string::npos) break;
+          n_begin = n_pos;
+          n_end = n_pos = n_close + 1;
+          return true;
+        }
+        else
+        {
+          n_pos++;
+        }
+      }
+      n_pos = n_size;
+      return false;
+    }
+
+    /**
+     * @brief This func check the text around the batches found by
+     *        _find_batch(): before the first one the declaration and the
+     *        open tag of root, between them nothing, and after the last one
+     *        the close tag of root, with blanks and comments anywhere.
+     *
+     * @ret   return true if the file is well formed when the batches are.
+     */
+    bool _check_batchText(const char *p_text, size_t n_size, const std::vector<std::pair<size_t, size_t> > &v_batchRange) const
+    {
+      if(v_batchRange.empty()) return false;
+
+      /* the open tag of root. */
+      size_t n_first = v_batchRange.front().first;
+      size_t n_pos = _skip_misc(p_text, 0, n_first);
+      if((n_pos >= n_first) || (p_text[n_pos] != '<')) return false;
+      size_t n_nameEnd = n_pos + 1;
+      while((n_nameEnd < n_first) && (strchr(" \t\r\n/>", p_text[n_nameEnd]) == NULL))
+      {
+        n_nameEnd++;
+      }
+      std::string str_root(p_text + n_pos + 1, n_nameEnd - n_pos - 1);
+      if(str_root.empty() || (str_root[0] == '!') || (str_root[0] == '?')) return false;
+      size_t n_close = _find_inText(p_text, n_first, n_pos, ">");
+      if((n_close == std::string::npos) || (p_text[n_close - 1] == '/')) return false;
+      if(_skip_misc(p_text, n_close + 1, n_first) != n_first) return false;
+
+      /* between the batches. */
+      for(size_t m = 1; m < v_batchRange.size(); m++)
+      {
+        if(_skip_misc(p_text, v_batchRange[m - 1].second, v_batchRange[m].first) != v_batchRange[m].first) return false;
+      }
+
+      /* the close tag of root. */
+      const std::string str_close = "</" + str_root;
+      n_pos = _skip_misc(p_text, v_batchRange.back().second, n_size);
+      if((n_size - n_pos < str_close.length()) || memcmp(p_text + n_pos, str_close.c_str(), str_close.length())) return false;
+      n_pos += str_close.length();
+      while((n_pos < n_size) && is_blank(p_text[n_pos]))
+      {
+        n_pos++;
+      }
+      if((n_pos >= n_size) || (p_text[n_pos] != '>')) return false;
+      return _skip_misc(p_text, n_pos + 1, n_size) == n_size;
+    }
+
+    /**
+     * @ret   return the position after the blanks, comments and processing
+     *        instructions from n_pos of p_text, not beyond n_end.
+     */
+    size_t _skip_misc(const char *p_text, size_t n_pos, size_t n_end) const
+    {
+      for( ; ; )
+      {
+        while((n_pos < n_end) && is_blank(p_text[n_pos]))
+        {
+          n_pos++;
+        }
+        size_t n_close = std::string::npos;
+        if((n_end - n_pos >= 4) && !memcmp(p_text + n_pos, "<!--", 4))
+        {
+          n_close = _find_inText(p_text, n_end, n_pos + 4, "-->");
+          if(n_close != std::string::npos) n_close += 3;
+        }
+        else if((n_end - n_pos >= 2) && !memcmp(p_text + n_pos, "<?", 2))
+        {
+          n_close = _find_inText(p_text, n_end, n_pos + 2, "?>");
+          if(n_close != std::string::npos) n_close += 2;
+        }
+        if(n_close == std::string::npos) return n_pos;
+        n_pos = n_close;
+      }
+    }
+
+    /**
+     * @brief This func find str_find in [n_from, n_size) of p_text, the text
+     *        needn't end with '\0'.
+     *
+     * @ret   return the position, or std::string::npos if not found.
+     */
+    size_t _find_inText(const char *p_text, size_t n_size, size_t n_from, const char* str_find) const
+    {
+      size_t n_len = strlen(str_find);
+      while(n_from + n_len <= n_size)
+      {
+        const char *p_find = static_cast<const char *>(memchr(p_text + n_from, str_find[0], n_size - n_len + 1 - n_from));
+        if(p_find == NULL) break;
+        n_from = p_find - p_text;
+        if(!memcmp(p_find, str_find, n_len)) return n_from;
+        n_from++;
+      }
+      return std::string::npos;
+    }
+
+    /**
+     * @brief This func parse the batches of one part into its own
+     *        dictionaries, it runs on a thread and only reads the tree.
+     */
+    void _parse_part(Tree_Part_t &s_part) const
+    {
+      try
+      {
+        rapidxml::xml_document<> xml_doc;
+        xml_doc.parse<0>(&s_part.v_text[0]);
+        Tree_BatchPlan_t s_plan; // each part learns its own.
+        rapidxml::xml_node<>* batch_node = xml_doc.first_node(C_strBatchTag.c_str());
+        for( ; batch_node != NULL; batch_node = batch_node->next_sibling(C_strBatchTag.c_str()))
+        {
+          if(!_parse_partBatch(s_part, batch_node, s_plan)) return;
+        }
+        s_part.is_valid = true;
+      }
+      catch(...) // broken xml, or out of memory, load serially to report it.
+      {
+        s_part.is_valid = false;
+      }
+    }
+
+    /**
+     * @ret return true if the batch can be added like _add_batch(), except
+     *      for the indexes used in tree or by other parts.
+     */
+    bool _parse_partBatch(Tree_Part_t &s_part, rapidxml::xml_node<>* batch_node, Tree_BatchPlan_t &s_plan) const
+    {
+      uint32_t batch_index = _get_batchIndex(batch_node);
+      size_t n_pos = 0;
+      for(rapidxml::xml_node<>* node_member = batch_node->first_node(); node_member != NULL; node_member = node_member->next_sibling(), n_pos++)
+      {
+        rapidxml::xml_attribute<>* name_attr = node_member->first_attribute(C_strNameTag.c_str());
+        rapidxml::xml_attribute<>* type_attr = node_member->first_attribute(C_strTypeTag.c_str());
+        if((batch_index == 0) || (name_attr == NULL) || (type_attr == NULL)) return false;
+        Tree_Item_t *member_item = _get_planItem(name_attr, n_pos, s_plan);
+        if(member_item == NULL) return false;
+
+        Tree_Val_t temp_val;
+        temp_val.e_type = _get_planType(type_attr, n_pos, s_plan);
+        if((temp_val.e_type == VAL_None) || (temp_val.e_type >= VAL_NUM)) return false;
+        if(!_set_memberVal(node_member->value(), node_member->value_size(), temp_val)) return false; // string points to the text of part.
+        _learn_planMember(name_attr, member_item, type_attr, temp_val.e_type, n_pos, s_plan);
+
+        auto iter_item = s_part.um_item.find(member_item);
+        if(iter_item == s_part.um_item.end())
+        {
+          s_part.v_item.push_back(member_item);
+          iter_item = s_part.um_item.insert(std::make_pair(member_item, Tree_PartItem_t())).first;
+        }
+        Tree_PartItem_t &s_partItem = iter_item->second;
+        if(!s_partItem.bm_batchIndex.add(batch_index)) return false; // the item is set twice in this batch.
+
+        Tree_PartItem_t::Tree_PartMember_t *member;
+        auto iter = s_partItem.um_member.find(&temp_val);
+        if(iter == s_partItem.um_member.end())
+        {
+          s_partItem.dq_member.push_back(Tree_PartItem_t::Tree_PartMember_t());
+          member = &s_partItem.dq_member.back();
+          member->s_val.e_type = temp_val.e_type;
+          member->s_val.u_val = temp_val.u_val;
+          member->s_val.n_memLen = temp_val.n_memLen;
+          s_partItem.um_member.insert(std::make_pair(&member->s_val, member));
+        }
+        else
+        {
+          member = iter->second;
+        }
+        member->bm_batchIndex.add(batch_index);
+      }
+      s_plan.is_learned = true;
+      s_part.v_batchIndex.push_back(batch_index);
+      return true;
+    }
+
+    /**
+     * @ret return true if all parts can be merged, so the batches of an item
+     *      are not in tree or in other parts, and strings are not added to
+     *      a dense item.
+     */
+    bool _check_parts(const std::vector<Tree_Part_t> &v_part) const
+    {
+      std::unordered_map<const Tree_Item_t *, Tree_Bitmap_t> um_itemBatch;
+      for(size_t m = 0; m < v_part.size(); m++)
+      {
+        if(!v_part[m].is_valid) return false;
+        for(auto iter = v_part[m].um_item.begin(); iter != v_part[m].um_item.end(); ++iter)
+        {
+          Tree_Bitmap_t &bm_batch = um_itemBatch[iter->first];
+          if(bm_batch.intersect_count(iter->second.bm_batchIndex) != 0) return false;
+          bm_batch.union_with(iter->second.bm_batchIndex);
+
+          if(iter->first->p_column != NULL) // strings turn it to members, in an order hard to follow.
+          {
+            const Tree_PartItem_t &s_partItem = iter->second;
+            for(auto iter_member = s_partItem.dq_member.begin(); iter_member != s_partItem.dq_member.end(); ++iter_member)
+            {
+              if(iter_member->s_val.e_type == VAL_String) return false;
+            }
+          }
+        }
+      }
+
+      bool is_used = false;
+      for(auto iter = um_itemBatch.begin(); (iter != um_itemBatch.end()) && !is_used; ++iter)
+      {
+        const Tree_Item_t *item_cur = iter->first;
+        if(item_cur->l_member.empty() && (item_cur->p_column == NULL)) continue; // no batch yet.
+        iter->second.for_each([&](uint32_t batch_index){
+          is_used = is_used || _has_batch(item_cur, batch_index);
+        });
+      }
+      return !is_used;
+    }
+
+    /**
+     * @brief This func merge the dictionaries of parts into tree, in order
+     *        of parts, so the members are added in the same order as
+     *        loading serially.
+     */
+    void _merge_parts(std::vector<Tree_Part_t> &v_part)
+    {
+      for(size_t m = 0; m < v_part.size(); m++)
+      {
+        Tree_Part_t &s_part = v_part[m];
+        for(auto iter = s_part.v_item.begin(); iter != s_part.v_item.end(); ++iter)
+        {
+          Tree_Item_t *item_cur = (*iter);
+          Tree_PartItem_t &s_partItem = s_part.um_item[item_cur];
+          if(item_cur->p_column == NULL)
+          {
+            _decode_item(item_cur); // run items have no index of batch.
+          }
+          for(auto iter_member = s_partItem.dq_member.begin(); iter_member != s_partItem.dq_member.end(); ++iter_member)
+          {
+            if(item_cur->p_column != NULL) // numbers only, checked by _check_parts().
+            {
+              iter_member->bm_batchIndex.for_each([&](uint32_t batch_index){
+                if(!_set_columnVal(item_cur, batch_index, iter_member->s_val))
+                {
+                  _decode_item(item_cur); // the batch is too far from the column.
+                  _add_memberVal(item_cur, iter_member->s_val, batch_index);
+                }
+              });
+              continue;
+            }
+            Tree_Member_t *member = _get_member(item_cur, iter_member->s_val);
+            member->bm_batchIndex.union_with(iter_member->bm_batchIndex);
+            iter_member->bm_batchIndex.for_each([&](uint32_t batch_index){
+              item_cur->um_batchMember[batch_index] = member;
+            });
+          }
+        }
+        for(auto iter = s_part.v_batchIndex.begin(); iter != s_part.v_batchIndex.end(); ++iter)
+        {
+          bm_batchIndex.add(*iter);
+        }
+      }
+    }
+
+    /**
+     * @ret Return ERR_None if all members of batch are pushed, otherwise return error code.
+     */
+    int _add_batch(rapidxml::xml_node<>* batch_node, Tree_BatchPlan_t &s_plan)
+    {
+      uint32_t batch_index = _get_batchIndex(batch_node);
+      __logMsg("\r\nadding batch %d\r\n", batch_index);
+      int ret = _push_memberVector(batch_node->first_node(), batch_index, s_plan, 0);
+      s_plan.is_learned = true;
+      if(ret == ERR_None)
+      {
+        bm_batchIndex.add(batch_index); // insert to batch index set for record usage.
+      }
+      return ret;
+    }
+
+    /**
+     * @brief This func find the next "Batch" element in the file, and copy
+     *        it into v_batch as a null-terminated string.
+     *
+     * @note  (1) v_window keeps the bytes read but not consumed yet, it is
+     *            filled by C_nStreamChunk bytes each time more is needed,
+     *            and the scanned part is dropped, so it never holds more
+     *            than one batch and one chunk.
+     *
+     *        (2) At the end of file v_window is empty, unless a batch or
+     *            comment is started but not closed, then it keeps the
+     *            bytes of it.
+     *
+     * @ret   return true if one batch is read, false at the end of file.
+     */
+    bool _read_batchFromStream(FILE *p_file, std::vector<char> &v_window, std::vector<char> &v_batch)
+    {
+      const std::string str_open = "<" + C_strBatchTag;
+      const std::string str_close = "</" + C_strBatchTag + ">";
+      const std::string str_comment = "<!--";
+      size_t n_pos = 0; // position of the tag being checked.
+
+      for( ; ; )
+      {
+        bool need_more = false;
+        n_pos = _find_inWindow(v_window, n_pos, "<");
+        if(n_pos == std::string::npos) // no tag in window, drop all of it.
+        {
+          n_pos = v_window.size();
+          need_more = true;
+        }
+        else if(v_window.size() - n_pos <= str_open.length()) // not enough bytes to know what the tag is.
+        {
+          need_more = true;
+        }
+        else if(!memcmp(&v_window[n_pos], str_comment.c_str(), str_comment.length())) // skip the comment.
+        {
+          size_t n_end = _find_inWindow(v_window, n_pos + str_comment.length(), "-->");
+          if(n_end == std::string::npos)
+          {
+            need_more = true;
+          }
+          else
+          {
+            n_pos = n_end + 3;
+          }
+        }
+        else if(!memcmp(&v_window[n_pos], str_open.c_str(), str_open.length())
+                && strchr(" \t\r\n/>", v_window[n_pos + str_open.length()]) != NULL) // start of batch.
+        {
+          size_t n_end = _find_inWindow(v_window, n_pos, ">");
+          if((n_end != std::string::npos) && (v_window[n_end - 1] != '/')) // not an empty element, find the close tag.
+          {
+            n_end = _find_inWindow(v_window, n_end, str_close.c_str());
+            if(n_end != std::string::npos)
+            {
+              n_end += str_close.length() - 1;
+            }
+          }
+          if(n_end == std::string::npos)
+          {
+            need_more = true;
+          }
+          else
+          {
+            v_batch.assign(v_window.begin() + n_pos, v_window.begin() + n_end + 1);
+            v_batch.push_back('\0');
+            v_window.erase(v_window.begin(), v_window.begin() + n_end + 1);
+            return true;
+          }
+        }
+        else
+        {
+          n_pos++;
+        }
+
+        if(need_more)
+        {
+          /* drop the scanned bytes, and append one chunk from file. */
+          v_window.erase(v_window.begin(), v_window.begin() + n_pos);
+          n_pos = 0;
+          size_t n_size = v_window.size();
+          v_window.resize(n_size + C_nStreamChunk);
+          size_t n_read = fread(&v_window[n_size], 1, C_nStreamChunk, p_file);
+          v_window.resize(n_size + n_read);
+          if(n_read == 0) // end of file.
+          {
+            size_t n_len = std::min(v_window.size(), str_open.length());
+            if(memcmp(&v_window[0], str_open.c_str(), n_len) && memcmp(&v_window[0], str_comment.c_str(), std::min(n_len, str_comment.length())))
+            {
+              v_window.clear(); // no element is started, such as the close tag of root.
+            }
+            return false;
+          }
+        }
+      }
+    }
+
+    size_t _find_inWindow(const std::vector<char> &v_window, size_t n_from, const char* str_find) const
+    {
+      size_t n_len = strlen(str_find);
+      if(v_window.size() >= n_len)
+      {
+        for(size_t m = n_from; m <= v_window.size() - n_len; m++)
+        {
+          if((v_window[m] == str_find[0]) && !memcmp(&v_window[m], str_find, n_len))
+          {
+            return m;
+          }
+        }
+      }
+      return std::string::npos;
+    }
+
+    /**
+     * @ret Return ERR_None if push member in vector succeed otherwise return error code.
+     *      Condition to succeed:
+     *      (1) all members in this batch are pushed successfully.
+     *          (ret |= _push_memberVector())
+     *
+     * @note  n_pos is the position of node_member in batch, for s_plan.
+     */
+    int _push_memberVector(const rapidxml::xml_node<>* node_member, uint32_t index_batch, Tree_BatchPlan_t &s_plan, size_t n_pos)
+    {
+      int ret = ERR_None;
+
+      if(node_member != NULL) // node is not null.
+      {
+        ret = ERR_IllegalIndex;
+        if(index_batch > 0) // index must > 0.
+        {
+          ret = ERR_NoXmlAttr;
+          rapidxml::xml_attribute<>* name_attr;
+          rapidxml::xml_attribute<>* type_attr;
+          if((name_attr = node_member->first_attribute(C_strNameTag.c_str())) != NULL) // node has name attribute.
+          {
+            ret = ERR_IllegalId;
+            Tree_Item_t *member_item = _get_planItem(name_attr, n_pos, s_plan);
+            if(member_item != NULL) // the id of item must be legal.
+            {
+              ret = ERR_UsedIndex;
+              if(!_has_batch(member_item, index_batch)) // this batch index has not been used.
+              {
+                ret = ERR_NoXmlAttr;
+                if((type_attr = node_member->first_attribute(C_strTypeTag.c_str())) != NULL) // node has type attribute.
+                {
+                  ret = ERR_IllegalValue;
+                  Tree_Val_t temp_val;
+                  temp_val.e_type = _get_planType(type_attr, n_pos, s_plan);
+                  if(_set_memberVal(node_member->value(), node_member->value_size(), temp_val)) // string points to the text in node.
+                  {
+                    __logMsg("item (%s) add value: ",member_item->str_name.c_str());__logVal((&temp_val));__logMsg("\r\n");
+
+                    if(!_set_columnVal(member_item, index_batch, temp_val))
+                    {
+                      _decode_item(member_item); // a string can not be kept in column, and run items have no index of batch.
+                      _add_memberVal(member_item, temp_val, index_batch);
+                    }
+                    _learn_planMember(name_attr, member_item, type_attr, temp_val.e_type, n_pos, s_plan);
+                    return _push_memberVector(node_member->next_sibling(), index_batch, s_plan, n_pos + 1);
+                  }
+                }
+              }
+            }
+          }
+        }
+      }
+      return ret;
+    }
+
+    /**
+     * @ret return the item of member at n_pos of batch, from s_plan if the
+     *      name is the planned one, otherwise it is searched by name. NULL
+     *      if there is no item with the name and a legal id.
+     */
+    Tree_Item_t *_get_planItem(const rapidxml::xml_attribute<> *name_attr, size_t n_pos, const Tree_BatchPlan_t &s_plan) const
+    {
+      if(n_pos < s_plan.v_member.size())
+      {
+        const Tree_BatchPlan_t::Tree_PlanMember_t &s_member = s_plan.v_member[n_pos];
+        if((name_attr->value_size() == s_member.str_name.size()) && !memcmp(name_attr->value(), s_member.str_name.data(), s_member.str_name.size()))
+        {
+          return s_member.p_item;
+        }
+      }
+      Tree_Item_t *member_item = _search_item_byName(name_attr->value());
+      if((member_item != NULL) && (_search_item_byId(_get_parentId(s_itemTable.v_id[member_item->n_pos])) == NULL))
+      {
+        member_item = NULL;
+      }
+      return member_item;
+    }
+
+    /**
+     * @ret return the type of member at n_pos of batch, from s_plan if the
+     *      text of type is the planned one.
+     */
+    Tree_Val_e _get_planType(const rapidxml::xml_attribute<> *type_attr, size_t n_pos, const Tree_BatchPlan_t &s_plan) const
+    {
+      if(n_pos < s_plan.v_member.size())
+      {
+        const Tree_BatchPlan_t::Tree_PlanMember_t &s_member = s_plan.v_member[n_pos];
+        if((type_attr->value_size() == s_member.str_type.size()) && !memcmp(type_attr->value(), s_member.str_type.data(), s_member.str_type.size()))
+        {
+          return s_member.e_type;
+        }
+      }
+      return _parse_strToType(type_attr->value());
+    }
+
+    /**
+     * @brief This func add the member at n_pos to s_plan, while the first
+     *        batch is read.
+     */
+    void _learn_planMember(const rapidxml::xml_attribute<> *name_attr, Tree_Item_t *member_item, const rapidxml::xml_attribute<> *type_attr,
+                           Tree_Val_e e_type, size_t n_pos, Tree_BatchPlan_t &s_plan) const
+    {
+      if(!s_plan.is_learned && (n_pos == s_plan.v_member.size()))
+      {
+        Tree_BatchPlan_t::Tree_PlanMember_t s_member;
+        s_member.str_name.assign(name_attr->value(), name_attr->value_size());
+        s_member.p_item = member_item;
+        s_member.str_type.assign(type_attr->value(), type_attr->value_size());
+        s_member.e_type = e_type;
+        s_plan.v_member.push_back(s_member);
+      }
+    }
+
+    /**
+     * @brief This func add value of one batch to the members of item.
+     */
+    void _add_memberVal(Tree_Item_t *member_item, const Tree_Val_t &temp_val, uint32_t index_batch)
+    {
+      Tree_Member_t *member = _get_member(member_item, temp_val);
+      member->bm_batchIndex.add(index_batch);
+      member_item->um_batchMember[index_batch] = member; // index the member by batch for reading.
+    }
+
+    /**
+     * @brief This func set the value of batch in the column of a dense item.
+     *
+     * @ret return false if item is not dense, s_val is not a number, or the
+     *      column would span more than C_nDenseSpan slots per value with
+     *      it. The item is not changed then and should be decoded.
+     */
+    bool _set_columnVal(Tree_Item_t *item_cur, uint32_t index_batch, const Tree_Val_t &s_val)
+    {
+      Tree_Column_t *p_column = item_cur->p_column;
+      if((p_column == NULL) || (p_column->get_span(index_batch) > C_nDenseSpan * (p_column->cardinality() + 1))) return false;
+      return p_column->set(index_batch, s_val);
+    }
+
+    /**
+     * @ret return the member of item with the value, a new one is pushed if
+     *      there is none.
+     */
+    Tree_Member_t *_get_member(Tree_Item_t *member_item, const Tree_Val_t &temp_val)
+    {
+      Tree_Member_t *member;
+      Tree_Val_t s_key; // value to look up, a string is the one in pool.
+      s_key.e_type = temp_val.e_type;
+      s_key.u_val = temp_val.u_val;
+      s_key.n_memLen = temp_val.n_memLen;
+      auto iter = member_item->um_member.end();
+      if(temp_val.e_type == VAL_String)
+      {
+        uint32_t n_strId = s_strPool.find(temp_val.u_val.val_string, temp_val.n_memLen);
+        if(n_strId != Tree_StrPool_t::C_nNoStr) // no member has a string not in pool.
+        {
+          s_key.u_val.val_string = const_cast<char *>(s_strPool.get_string(n_strId));
+          iter = member_item->um_member.find(&s_key);
+        }
+      }
+      else
+      {
+        iter = member_item->um_member.find(&s_key);
+      }
+      if(iter == member_item->um_member.end()) // the member with this val is not in vector, push a new one.
+      {
+        member = _new_member();
+        member->s_val.e_type = temp_val.e_type;
+        member->s_val.u_val = temp_val.u_val;
+        member->s_val.n_memLen = temp_val.n_memLen;
+        if(temp_val.e_type == VAL_String)
+        {
+          member->n_strId = s_strPool.intern(temp_val.u_val.val_string, temp_val.n_memLen, false); // copy the text of node.
+          member->s_val.u_val.val_string = const_cast<char *>(s_strPool.get_string(member->n_strId));
+        }
+        member->iter_member = member_item->l_member.insert(member_item->l_member.end(), member);
+        member_item->um_member.insert(std::make_pair(&member->s_val, member));
+        member_item->is_sorted = false;
+      }
+      else // the member with this val is already in vector, only push the batch id to member's id vector (save space).
+      {
+        member = iter->second;
+      }
+      return member;
+    }
+
+    /**
+     * @brief This func measure the values of item and choose its encoding,
+     *        see optimize().
+     */
+    void _optimize_item(Tree_Item_t *item_cur)
+    {
+      _decode_item(item_cur); // measure on members.
+
+      Tree_Encoding_t &s_encoding = item_cur->s_encoding;
+      uint32_t n_min = 0xffffffff, n_max = 0;
+      bool is_number = true;
+      s_encoding.n_batchNum = 0;
+      s_encoding.n_distinctNum = item_cur->l_member.size();
+      s_encoding.n_runNum = 0;
+      for(auto iter = item_cur->l_member.begin(); iter != item_cur->l_member.end(); ++iter)
+      {
+        const Tree_Member_t *member = (*iter);
+        is_number = is_number && ((member->s_val.e_type == VAL_Int) || (member->s_val.e_type == VAL_Double));
+        s_encoding.n_batchNum += member->bm_batchIndex.cardinality();
+        s_encoding.n_runNum += member->bm_batchIndex.count_runs();
+        member->bm_batchIndex.for_each([&](uint32_t batch_index){
+          n_min = std::min(n_min, batch_index);
+          n_max = std::max(n_max, batch_index);
+        });
+      }
+
+      if(s_encoding.n_batchNum == 0)
+      {
+        /* no value, keep it as it is. */
+      }
+      else if((s_encoding.n_runNum * C_nRunLength <= s_encoding.n_batchNum) && (s_encoding.n_distinctNum <= C_nRunMaxMember))
+      {
+        _encode_run(item_cur);
+      }
+      else if(is_number && (s_encoding.n_distinctNum * C_nDenseRatio >= s_encoding.n_batchNum)
+              && (static_cast<uint64_t>(n_max - n_min) + 1 <= C_nDenseSpan * s_encoding.n_batchNum))
+      {
+        _encode_dense(item_cur);
+      }
+      else
+      {
+        for(auto iter = item_cur->l_member.begin(); iter != item_cur->l_member.end(); ++iter)
+        {
+          (*iter)->bm_batchIndex.run_optimize();
+        }
+      }
+      __logMsg("item (%s) encoding %d: batches %llu, distinct values %llu, runs %llu\r\n", item_cur->str_name.c_str(), s_encoding.e_encoding,
+               (unsigned long long)s_encoding.n_batchNum, (unsigned long long)s_encoding.n_distinctNum, (unsigned long long)s_encoding.n_runNum);
+    }
+
+    void _encode_run(Tree_Item_t *item_cur)
+    {
+      for(auto iter = item_cur->l_member.begin(); iter != item_cur->l_member.end(); ++iter)
+      {
+        (*iter)->bm_batchIndex.run_optimize();
+      }
+      Tree_BatchMemberMap_t(0, std::hash<uint32_t>(), std::equal_to<uint32_t>(), &s_arena).swap(item_cur->um_batchMember); // free the buckets too.
+      item_cur->s_encoding.e_encoding = ENC_Run;
+    }
+
+    void _encode_dense(Tree_Item_t *item_cur)
+    {
+      item_cur->p_column = new Tree_Column_t;
+      for(auto iter = item_cur->l_member.begin(); iter != item_cur->l_member.end(); ++iter)
+      {
+        Tree_Member_t *member = (*iter);
+        member->bm_batchIndex.for_each([&](uint32_t batch_index){
+          item_cur->p_column->set(batch_index, member->s_val);
+        });
+        _delete_member(member);
+      }
+      item_cur->p_column->shrink(); // members are not in order of batch, the column may have grown too much in front.
+      item_cur->l_member.clear();
+      Tree_MemberDict_t(0, Tree_MemberHash_t(), Tree_MemberEqual_t(), &s_arena).swap(item_cur->um_member); // free the buckets too.
+      Tree_BatchMemberMap_t(0, std::hash<uint32_t>(), std::equal_to<uint32_t>(), &s_arena).swap(item_cur->um_batchMember);
+      std::vector<Tree_Member_t *>().swap(item_cur->v_sortedMember);
+      item_cur->is_sorted = false;
+      item_cur->s_encoding.e_encoding = ENC_Dense;
+    }
+
+    /**
+     * @brief This func turn item back to ENC_Dictionary.
+     */
+    void _decode_item(Tree_Item_t *item_cur)
+    {
+      if(item_cur->s_encoding.e_encoding == ENC_Dense)
+      {
+        Tree_Column_t *p_column = item_cur->p_column;
+        item_cur->p_column = NULL;
+        p_column->for_each([&](uint32_t batch_index, const Tree_Val_t &s_val){
+          _add_memberVal(item_cur, s_val, batch_index);
+        });
+        delete p_column;
+      }
+      else if(item_cur->s_encoding.e_encoding == ENC_Run)
+      {
+        for(auto iter = item_cur->l_member.begin(); iter != item_cur->l_member.end(); ++iter)
+        {
+          Tree_Member_t *member = (*iter);
+          member->bm_batchIndex.for_each([&](uint32_t batch_index){
+            item_cur->um_batchMember[batch_index] = member;
+          });
+        }
+      }
+      item_cur->s_encoding.e_encoding = ENC_Dictionary;
+    }
+
+    /**
+     * @ret return estimated bytes used by values of item.
+     */
+    size_t _get_itemMemSize(const Tree_Item_t *item_cur) const
+    {
+      size_t n_size = 0;
+      if(item_cur->p_column != NULL)
+      {
+        n_size += item_cur->p_column->get_memSize();
+      }
+      for(auto iter = item_cur->l_member.begin(); iter != item_cur->l_member.end(); ++iter)
+      {
+        const Tree_Member_t *member = (*iter);
+        n_size += sizeof(Tree_Member_t) - sizeof(Tree_Bitmap_t) + member->bm_batchIndex.get_memSize() + 3 * sizeof(void *); // with node of list.
+        if((member->s_val.e_type == VAL_String) && !s_strPool.is_borrowed(member->n_strId))
+        {
+          n_size += member->s_val.n_memLen / s_strPool.get_refNum(member->n_strId); // shared by the members using it.
+        }
+      }
+      n_size += item_cur->um_member.size() * (sizeof(Tree_MemberDict_t::value_type) + sizeof(void *))
+                + item_cur->um_member.bucket_count() * sizeof(void *);
+      n_size += item_cur->um_batchMember.size() * (sizeof(Tree_BatchMemberMap_t::value_type) + sizeof(void *))
+                + item_cur->um_batchMember.bucket_count() * sizeof(void *);
+      n_size += item_cur->v_sortedMember.capacity() * sizeof(Tree_Member_t *);
+      return n_size;
+    }
+
+    /**
+     * @note  (1) str_val must be null-terminated, a string value points to
+     *            str_val instead of copying it, so it is valid as long as
+     *            str_val is.
+     *
+     *        (2) Numbers are parsed on str_val and n_len, nothing is
+     *            allocated, see parse_intVal() and parse_doubleVal().
+     *
+     * @ret   return false if a number is malformed, or the type is not one
+     *        of int, double and string.
+     */
+    bool _set_memberVal(char* str_val, size_t n_len, Tree_Val_t &s_val) const
+    {
+      switch(s_val.e_type)
+      {
+      case VAL_String:
+        {
+          s_val.n_memLen = n_len+1;
+          s_val.u_val.val_string = str_val;
+          break;
+        }
+      case VAL_Int:
+        return parse_intVal(str_val, n_len, s_val.u_val.val_int);
+      case VAL_Double:
+        return parse_doubleVal(str_val, n_len, s_val.u_val.val_double);
+      default:
+        return false; // unknown type, it could not be kept or saved.
+      }
+      return true;
+    }
+
+    int _get_memberVal(const Tree_Item_t *item_member, uint32_t n_batchIndex, Tree_Val_t &s_val) const
+    {
+      Tree_Val_t temp_val;
+      if((item_member != NULL) && _find_val(item_member, n_batchIndex, temp_val))
+      {
+        s_val = temp_val; // copy the string.
+        return ERR_None; // get the val.
+      }
+      return ERR_UnregisteredIndex; // not get the val.
+    }
+
+    /**
+     * @note  s_val is copied by member, a string points to the value kept
+     *        by tree.
+     *
+     * @ret   return true if item has a value of the batch.
+     */
+    bool _find_val(const Tree_Item_t *item_cur, uint32_t n_batchIndex, Tree_Val_t &s_val) const
+    {
+      const Tree_Member_t *member = NULL;
+      if(item_cur->p_column != NULL)
+      {
+        return item_cur->p_column->get(n_batchIndex, s_val);
+      }
+      else if(item_cur->s_encoding.e_encoding == ENC_Run)
+      {
+        member = _find_runMember(item_cur, n_batchIndex);
+      }
+      else
+      {
+        auto iter = item_cur->um_batchMember.find(n_batchIndex);
+        if(iter != item_cur->um_batchMember.end()) member = iter->second;
+      }
+      if(member != NULL)
+      {
+        s_val.e_type = member->s_val.e_type;
+        s_val.u_val = member->s_val.u_val;
+        s_val.n_memLen = member->s_val.n_memLen;
+        return true;
+      }
+      return false;
+    }
+
+    bool _has_batch(const Tree_Item_t *item_cur, uint32_t n_batchIndex) const
+    {
+      if(item_cur->p_column != NULL)
+      {
+        return item_cur->p_column->contains(n_batchIndex);
+      }
+      else if(item_cur->s_encoding.e_encoding == ENC_Run)
+      {
+        return _find_runMember(item_cur, n_batchIndex) != NULL;
+      }
+      return item_cur->um_batchMember.find(n_batchIndex) != item_cur->um_batchMember.end();
+    }
+
+    /**
+     * @ret return the member of item holding the batch, found in bitmaps
+     *         of members for a ENC_Run item, NULL if not found.
+     */
+    const Tree_Member_t *_find_runMember(const Tree_Item_t *item_cur, uint32_t n_batchIndex) const
+    {
+      for(auto iter = item_cur->l_member.begin(); iter != item_cur->l_member.end(); ++iter)
+      {
+        if((*iter)->bm_batchIndex.contains(n_batchIndex)) return (*iter);
+      }
+      return NULL;
+    }
+
+    uint32_t _get_batchIndex(rapidxml::xml_node<>* node_batch) const
+    {
+      rapidxml::xml_attribute<>* temp_attr;
+      if((temp_attr = node_batch->first_attribute(C_strIndexTag.c_str())) != NULL) // node has index attribute.
+      {
+        char *p_char;
+        uint32_t batch_index = strtol(temp_attr->value(), &p_char, FORMAT_Batch_Index);
+        return batch_index;
+      }
+      return 0;
+    }
+
+    void _get_membersOfBatch(uint32_t n_batchIndex, std::map<std::string, Tree_Val_t*> &m_batch) const
+    {
+      for(size_t m = 0; m < s_itemTable.v_item.size(); m++)
+      {
+        Tree_Val_t *new_val = new Tree_Val_t;
+        new_val->e_type = VAL_None;
+        _get_memberVal(s_itemTable.v_item[m], n_batchIndex, *new_val); // get the value from tree.
+        m_batch.insert(std::make_pair(s_itemTable.v_name[m], new_val)); // insert name and value into batch map.
+      }
+    }
+
+    /**
+     * @brief This func call fn(batch_index, s_val) for each value of item,
+     *        s_val is the value kept by tree.
+     *
+     * @note  (1) Values of a dense item are in order of batch, the others
+     *            are in order of member.
+     */
+    template<class Fn>
+    void _for_eachValOfItem(const Tree_Item_t* item_cur, Fn fn) const
+    {
+      if(item_cur->p_column != NULL)
+      {
+        item_cur->p_column->for_each(fn);
+        return;
+      }
+      for(auto iter = item_cur->l_member.begin(); iter != item_cur->l_member.end(); ++iter)
+      {
+        const Tree_Member_t *member = (*iter);
+        member->bm_batchIndex.for_each([&](uint32_t batch_index){
+          fn(batch_index, member->s_val);
+        });
+      }
+    }
+
+    void _get_membersOfItem(const Tree_Item_t* item_cur, std::map<uint32_t, Tree_Val_t*> &m_item) const
+    {
+      _for_eachValOfItem(item_cur, [&](uint32_t batch_index, const Tree_Val_t &s_val){
+        Tree_Val_t* new_val = new Tree_Val_t;
+        (*new_val) = s_val; // the member owns this batch, copy its value directly.
+        m_item.insert(m_item.end(), std::make_pair(batch_index, new_val)); // hint is right for dense items, whose batches are in order.
+      });
+    }
+
+    /**
+     * @brief This func delete the values of batches in bm_delete from item,
+     *        all the batches must be in tree.
+     *
+     * @note  (1) A dictionary item with more members than batches to delete
+     *            finds the member of each batch in um_batchMember, so only
+     *            the members holding the batches are touched. Otherwise,
+     *            such as a run item or a large delete, bm_delete is
+     *            subtracted from the bitmap of each member at once.
+     *
+     *        (2) A member left without batch is erased from l_member by its
+     *            own position.
+     */
+    void _delete_membersOfBatch(Tree_Item_t* item_cur, const Tree_Bitmap_t &bm_delete)
+    {
+      if(item_cur->p_column != NULL)
+      {
+        bm_delete.for_each([&](uint32_t batch_index){
+          item_cur->p_column->remove(batch_index);
+        });
+      }
+      else if((item_cur->s_encoding.e_encoding == ENC_Dictionary) && (bm_delete.cardinality() < item_cur->l_member.size()))
+      {
+        bm_delete.for_each([&](uint32_t batch_index){
+          auto iter = item_cur->um_batchMember.find(batch_index);
+          if(iter != item_cur->um_batchMember.end())
+          {
+            Tree_Member_t *member = iter->second;
+            item_cur->um_batchMember.erase(iter);
+            member->bm_batchIndex.remove(batch_index);
+            if(member->bm_batchIndex.empty()) _erase_member(item_cur, member);
+          }
+        });
+      }
+      else
+      {
+        for(auto iter = item_cur->l_member.begin(); iter != item_cur->l_member.end(); )
+        {
+          Tree_Member_t *member = *(iter++); // erasing the member does not move iter.
+          member->bm_batchIndex.subtract(bm_delete);
+          if(member->bm_batchIndex.empty()) _erase_member(item_cur, member);
+        }
+        if(item_cur->s_encoding.e_encoding == ENC_Dictionary)
+        {
+          bm_delete.for_each([&](uint32_t batch_index){
+            item_cur->um_batchMember.erase(batch_index);
+          });
+        }
+      }
+    }
+
+    /**
+     * @brief This func erase a member without batch from its item.
+     */
+    void _erase_member(Tree_Item_t* item_cur, Tree_Member_t *member)
+    {
+      item_cur->um_member.erase(&member->s_val);
+      item_cur->l_member.erase(member->iter_member);
+      _delete_member(member);
+      item_cur->is_sorted = false;
+    }
+
+    void _delete_batches(const Tree_Bitmap_t &bm_delete)
+    {
+      if(!bm_delete.empty())
+      {
+        for(size_t m = 0; m < s_itemTable.v_item.size(); m++)
+        {
+          _delete_membersOfBatch(s_itemTable.v_item[m], bm_delete);
+        }
+        bm_batchIndex.subtract(bm_delete);
+      }
+    }
+
+    /**
+     * @ret return true if s_val is a number other than NaN, and set it to d_val.
+     */
+    static bool _get_numberVal(const Tree_Val_t &s_val, double &d_val)
+    {
+      if(s_val.e_type == VAL_Int) d_val = s_val.u_val.val_int;
+      else if(s_val.e_type == VAL_Double) d_val = s_val.u_val.val_double;
+      else return false;
+      return d_val == d_val;
+    }
+
+    /**
+     * @brief This func call fn(value, bitmap of batches) for each distinct
+     *        value of item, members of a dense item are made by grouping
+     *        its column.
+     */
+    template<class Fn>
+    void _for_eachGroup(const Tree_Item_t *item_cur, Fn fn) const
+    {
+      if(item_cur->p_column != NULL)
+      {
+        /* group by type and bits of value, so NaN is a group too. */
+        std::map<std::pair<int, uint64_t>, Tree_Bitmap_t> m_group;
+        item_cur->p_column->for_each([&](uint32_t n_batchIndex, const Tree_Val_t &s_val){
+          uint64_t n_bits = 0;
+          if(s_val.e_type == VAL_Int) n_bits = static_cast<uint32_t>(s_val.u_val.val_int);
+          else memcpy(&n_bits, &s_val.u_val.val_double, sizeof(n_bits));
+          m_group[std::make_pair(static_cast<int>(s_val.e_type), n_bits)].add(n_batchIndex);
+        });
+        for(auto iter = m_group.begin(); iter != m_group.end(); ++iter)
+        {
+          Tree_Val_t s_val;
+          s_val.e_type = static_cast<Tree_Val_e>(iter->first.first);
+          s_val.n_memLen = 0;
+          if(s_val.e_type == VAL_Int) s_val.u_val.val_int = static_cast<int>(static_cast<uint32_t>(iter->first.second));
+          else memcpy(&s_val.u_val.val_double, &iter->first.second, sizeof(double));
+          fn(s_val, iter->second);
+        }
+        return;
+      }
+      for(auto iter = item_cur->l_member.begin(); iter != item_cur->l_member.end(); ++iter)
+      {
+        fn((*iter)->s_val, (*iter)->bm_batchIndex);
+      }
+    }
+
+    /**
+     * @brief This func call fn(value, number of batches) for each member of
+     *        item with a number value, the batches are limited to
+     *        bm_filter if it is not NULL. Members of no batch are skipped.
+     */
+    template<class Fn>
+    void _for_eachNumberMember(const Tree_Item_t *item_cur, const Tree_Bitmap_t *bm_filter, Fn fn) const
+    {
+      if(item_cur->p_column != NULL) // each batch is a member of itself.
+      {
+        item_cur->p_column->for_each([&](uint32_t n_batchIndex, const Tree_Val_t &s_val){
+          double d_val;
+          if(_get_numberVal(s_val, d_val) && ((bm_filter == NULL) || bm_filter->contains(n_batchIndex))) fn(d_val, 1);
+        });
+        return;
+      }
+      for(auto iter = item_cur->l_member.begin(); iter != item_cur->l_member.end(); ++iter)
+      {
+        const Tree_Member_t *member = (*iter);
+        double d_val;
+        if(!_get_numberVal(member->s_val, d_val)) continue;
+
+        uint64_t n_weight = (bm_filter != NULL) ? member->bm_batchIndex.intersect_count(*bm_filter) : member->bm_batchIndex.cardinality();
+        if(n_weight != 0) fn(d_val, n_weight);
+      }
+    }
+
+    /**
+     * @brief This func compute statistics of item over the batches of
+     *        bm_batch by looking up the value of each batch, same result as
+     *        stat_oneItem().
+     */
+    void _stat_byBatch(const Tree_Item_t *item_cur, const Tree_Bitmap_t &bm_batch, Tree_Stat_t &s_stat) const
+    {
+      memset(&s_stat, 0, sizeof(s_stat));
+      bm_batch.for_each([&](uint32_t n_batchIndex){
+        Tree_Val_t s_val;
+        double d_val;
+        if(!_find_val(item_cur, n_batchIndex, s_val) || !_get_numberVal(s_val, d_val)) return;
+
+        if((s_stat.n_count == 0) || (d_val < s_stat.d_min)) s_stat.d_min = d_val;
+        if((s_stat.n_count == 0) || (d_val > s_stat.d_max)) s_stat.d_max = d_val;
+        s_stat.n_count++;
+        s_stat.d_sum += d_val;
+      });
+      if(s_stat.n_count != 0) s_stat.d_avg = s_stat.d_sum / s_stat.n_count;
+    }
+
+    int _check_query(const Tree_Query_t &s_query) const
+    {
+      switch(s_query.e_op)
+      {
+      case QUERY_Pred:
+        return (s_query.h_item != NULL) ? ERR_None : ERR_UnregisteredItem;
+      case QUERY_And:
+      case QUERY_Or:
+        if(s_query.v_child.empty()) return ERR_IllegalQuery;
+        break;
+      case QUERY_Not:
+        if(s_query.v_child.size() != 1) return ERR_IllegalQuery;
+        break;
+      default:
+        return ERR_IllegalQuery;
       }
-      return ret;
+      for(size_t m = 0; m < s_query.v_child.size(); m++)
+      {
+        int ret = _check_query(s_query.v_child[m]);
+        if(ret != ERR_None) return ret;
+      }
+      return ERR_None;
     }
 
-    void _free_itemTree(Tree_Item_t *item_cur)
+    /**
+     * @ret return estimated number of batches matching query, exact for a
+     *         predicate, bounded by its childs for AND, OR and NOT.
+     */
+    uint64_t _estimate_query(const Tree_Query_t &s_query) const
     {
-      if(item_cur != NULL)
+      uint64_t n_all = bm_batchIndex.cardinality(), n_est = 0;
+      switch(s_query.e_op)
       {
-        /* free the space of value. */
-        for(auto iter = item_cur->l_member.begin(); iter != item_cur->l_member.end(); ++iter)
+      case QUERY_Pred:
+        count_oneItem(s_query.h_item, s_query.s_pred, n_est);
+        break;
+      case QUERY_And:
+        n_est = n_all;
+        for(size_t m = 0; m < s_query.v_child.size(); m++)
         {
-          Tree_Member_t *member = (*iter);
-          if(member->s_val.e_type == VAL_String)
-          {
-            delete[] member->s_val.u_val.val_string;
-          }
-          delete member;
+          n_est = std::min(n_est, _estimate_query(s_query.v_child[m]));
         }
-        item_cur->l_member.clear();
-
-        for(auto iter = item_cur->v_childItem.begin(); iter != item_cur->v_childItem.end(); ++iter)
+        break;
+      case QUERY_Or:
+        for(size_t m = 0; (m < s_query.v_child.size()) && (n_est < n_all); m++)
         {
-          Tree_Item_t *temp_item = (*iter);
-          _free_itemTree(temp_item);
+          n_est += _estimate_query(s_query.v_child[m]);
         }
-
-        item_cur->v_childItem.clear();
-        /* free the space of item. */
-        delete item_cur;
+        n_est = std::min(n_est, n_all);
+        break;
+      case QUERY_Not:
+        n_est = n_all - std::min(n_all, _estimate_query(s_query.v_child[0]));
+        break;
+      default:
+        break;
       }
+      return n_est;
     }
 
-    Tree_Item_t *_search_item_byId(uint32_t n_id)
+    void _eval_query(const Tree_Query_t &s_query, Tree_Bitmap_t &bm_result) const
     {
-      Tree_Item_t *temp_item = &s_rootItem;
-      uint32_t temp_id = n_id;
-
-      if(n_id == 0) return &s_rootItem;
-
-      while((temp_item != NULL) && (temp_id != 0))
+      Tree_Bitmap_t bm_child;
+      switch(s_query.e_op)
       {
-        uint32_t index = (temp_id & C_nMaxItem);
-        if((index == 0) || (index > temp_item->v_childItem.size()))
-        {
-          break;
-        }
-        temp_item = temp_item->v_childItem[index-1];
-        if(temp_item->n_id == n_id)
+      case QUERY_Pred:
+        query_oneItem(s_query.h_item, s_query.s_pred, bm_result);
+        break;
+      case QUERY_And:
+        _eval_andQuery(s_query, &bm_result);
+        break;
+      case QUERY_Or:
+        bm_result.clear();
+        for(size_t m = 0; m < s_query.v_child.size(); m++)
         {
-          return temp_item;
+          _eval_query(s_query.v_child[m], bm_child);
+          bm_result.union_with(bm_child);
         }
-        temp_id >>= C_nCrorNum;
+        break;
+      case QUERY_Not:
+        _eval_query(s_query.v_child[0], bm_child);
+        bm_result = bm_batchIndex;
+        bm_result.subtract(bm_child);
+        break;
+      default:
+        bm_result.clear();
+        break;
       }
-      return NULL;
     }
 
-    Tree_Item_t* _search_item_byName(const Tree_Item_t *item_parent, const char* str_itemName) const
+    /**
+     * @brief This func evaluate AND from its most selective child.
+     *
+     * @output bm_result: bitmap of matched batches, NULL to only count
+     *         them, then the last child is counted against the others.
+     *
+     * @ret   return number of matched batches.
+     */
+    uint64_t _eval_andQuery(const Tree_Query_t &s_query, Tree_Bitmap_t *bm_result) const
     {
-      uint32_t id = 0;
-      Tree_Item_t* ret_item = NULL;
+      std::vector<std::pair<uint64_t, const Tree_Query_t *> > v_order;
+      for(size_t m = 0; m < s_query.v_child.size(); m++)
+      {
+        /* NOT is ordered by how many batches it keeps, like the others. */
+        v_order.push_back(std::make_pair(_estimate_query(s_query.v_child[m]), &s_query.v_child[m]));
+      }
+      std::stable_sort(v_order.begin(), v_order.end(),
+      [](const std::pair<uint64_t, const Tree_Query_t *> &a, const std::pair<uint64_t, const Tree_Query_t *> &b){
+        return a.first < b.first;
+      });
 
-      if(item_parent != NULL)
+      Tree_Bitmap_t bm_local, bm_child;
+      Tree_Bitmap_t &bm_and = (bm_result != NULL) ? (*bm_result) : bm_local;
+      size_t n_first = 0, n_last = v_order.size() - 1;
+      /* start from the most selective child which is not NOT, or from all batches. */
+      while((n_first < v_order.size()) && (v_order[n_first].second->e_op == QUERY_Not)) n_first++;
+      if(n_first == n_last) n_last--;
+      if(n_first < v_order.size())
       {
-        for(auto iter = item_parent->v_childItem.begin(); iter != item_parent->v_childItem.end(); ++iter)
-        {
-          Tree_Item_t *child_item = (*iter);
-          ret_item = _search_item_byName(child_item, str_itemName);
-          if(!strcmp(child_item->str_name.c_str(), str_itemName))
-          {
-            ret_item = child_item;
-          }
-          if(ret_item != NULL) break;
-        }
+        _eval_query(*v_order[n_first].second, bm_and);
+      }
+      else
+      {
+        bm_and = bm_batchIndex;
       }
-      return ret_item;
-    }
 
-    uint32_t _get_parentId(uint32_t id_child) const
-    {
-      if(id_child != 0)
+      for(size_t m = 0; (m < v_order.size()) && !bm_and.empty(); m++)
       {
-        int cror = 0;
-        while(id_child)
+        if(m == n_first) continue;
+        const Tree_Query_t &s_child = *v_order[m].second;
+        bool is_not = (s_child.e_op == QUERY_Not);
+        _eval_query(is_not ? s_child.v_child[0] : s_child, bm_child);
+        if((bm_result == NULL) && (m == n_last))
         {
-          cror++;
-          id_child >>= C_nCrorNum;
+          uint64_t n_common = bm_and.intersect_count(bm_child);
+          return is_not ? (bm_and.cardinality() - n_common) : n_common;
         }
-        return id_child & ((1 << C_nCrorNum*(cror-1)) - 1);
+        if(is_not) bm_and.subtract(bm_child);
+        else bm_and.intersect_with(bm_child);
       }
-      return 0;
+      return bm_and.cardinality();
     }
 
     /**
-     * @ret Return ERR_None if push member in vector succeed otherwise return error code.
-     *      Condition to succeed:
-     *      (1) all members in this batch are pushed successfully.
-     *          (ret |= _push_memberVector())
+     * @brief This func call fn(member) for each member of item whose value
+     *        matches the predicate.
+     *
+     * @note  (1) Small items are scanned, others are searched in the sorted
+     *            dictionary, which is sorted first if it is out of date.
      */
-    int _push_memberVector(const rapidxml::xml_node<>* node_member, uint32_t index_batch)
+    template<class Fn>
+    void _for_eachMatchedMember(const Tree_Item_t *item_cur, const Tree_Pred_t &s_pred, Fn fn) const
     {
-      int ret = ERR_None;
-
-      if(node_member != NULL) // node is not null.
+      if(item_cur->l_member.size() <= C_nMaxScanMember)
       {
-        ret = ERR_IllegalIndex;
-        if(index_batch > 0) // index must > 0.
+        for(auto iter = item_cur->l_member.begin(); iter != item_cur->l_member.end(); ++iter)
         {
-          ret = ERR_NoXmlAttr;
-          rapidxml::xml_attribute<>* temp_attr;
-          if((temp_attr = node_member->first_attribute(C_strNameTag.c_str())) != NULL) // node has name attribute.
-          {
-            ret = ERR_IllegalId;
-            Tree_Item_t *member_item = _search_item_byName(&s_rootItem, temp_attr->value());
-            if((member_item != NULL) && (_search_item_byId(_get_parentId(member_item->n_id)) != NULL)) // the id of item must be legal.
-            {
-              ret = ERR_UsedIndex;
-              Tree_Val_t temp_val;
-              if(_get_memberVal(member_item, index_batch, temp_val) == ERR_UnregisteredIndex) // this batch index has not been used.
-              {
-                ret = ERR_NoXmlAttr;
-                if((temp_attr = node_member->first_attribute(C_strTypeTag.c_str())) != NULL) // node has type attribute.
-                {
-                  ret = ERR_None;
-                  Tree_Val_t temp_val;
-                  temp_val.e_type = _parse_strToType(temp_attr->value());
-                  _set_memberVal(node_member->value(), temp_val);
-
-                  __logMsg("item (%s) add value: ",member_item->str_name.c_str());__logVal((&temp_val));__logMsg("\r\n");
+          if(_match_pred((*iter)->s_val, s_pred)) fn(*iter);
+        }
+        return;
+      }
 
-                  auto iter = std::find_if(member_item->l_member.begin(), member_item->l_member.end(),
-                  [=](Tree_Member_t *member){
-                    return member->s_val == temp_val;
-                  });
-                  if(iter == member_item->l_member.end()) // the member with this val is not in vector, push a new one.
-                  {
-                    Tree_Member_t *new_member = new Tree_Member_t;
-                    new_member->s_val = temp_val;
-                    new_member->set_batchIndex.insert(index_batch);
-                    member_item->l_member.push_back(new_member);
-                  }
-                  else // the member with this val is already in vector, only push the batch id to member's id vector (save space).
-                  {
-                    Tree_Member_t *member = (*iter);
-                    member->set_batchIndex.insert(index_batch);
-                  }
-                  return _push_memberVector(node_member->next_sibling(), index_batch);
-                }
-              }
-            }
-          }
+      size_t n_begin[2], n_end[2];
+      int n_rangeNum = _get_predRanges(item_cur, s_pred, n_begin, n_end);
+      for(int m = 0; m < n_rangeNum; m++)
+      {
+        for(size_t n = n_begin[m]; n < n_end[m]; n++)
+        {
+          fn(item_cur->v_sortedMember[n]);
         }
       }
-      return ret;
     }
 
-    void _set_memberVal(const std::string &str_val, Tree_Val_t &s_val)
+    /**
+     * @note  rank of value in sorted dictionary: numbers, then NaN, then
+     *        strings. Only numbers and strings are comparable.
+     */
+    static int _get_valRank(const Tree_Val_t &s_val)
     {
       switch(s_val.e_type)
       {
-      case VAL_String:
-        {
-          s_val.n_memLen = str_val.length()+1;
-          char* val = new char[s_val.n_memLen];
-          memcpy(val, str_val.c_str(), s_val.n_memLen);
-          s_val.u_val.val_string = val;
-          break;
-        }
       case VAL_Int:
-        {
-          char *p_char;
-          int val = strtol(str_val.c_str(), &p_char, 10);
-          s_val.u_val.val_int = val;
-        }
-        break;
+        return C_nRankNumber;
       case VAL_Double:
-        {
-          char *p_char;
-          double val = strtod(str_val.c_str(), &p_char);
-          s_val.u_val.val_double = val;
-        }
-        break;
+        return (s_val.u_val.val_double == s_val.u_val.val_double) ? C_nRankNumber : C_nRankNaN;
+      case VAL_String:
+        return C_nRankString;
       default:
-        break;
+        return C_nRankNone;
       }
     }
 
-    int _get_memberVal(const Tree_Item_t *item_member, uint32_t n_batchIndex, Tree_Val_t &s_val) const
+    /**
+     * @ret return <0, 0, >0 as val_a is before, equal to, after val_b in sorted dictionary.
+     */
+    static int _order_val(const Tree_Val_t &val_a, const Tree_Val_t &val_b)
     {
-      if(item_member != NULL)
+      int n_rankA = _get_valRank(val_a), n_rankB = _get_valRank(val_b);
+      int n_cmp = 0;
+      if(n_rankA != n_rankB) return n_rankA - n_rankB;
+      if((n_rankA == C_nRankNumber) || (n_rankA == C_nRankString))
       {
-        for(auto iter = item_member->l_member.begin(); iter != item_member->l_member.end(); ++iter)
-        {
-          Tree_Member_t* member = (*iter);
-          auto iter2 = member->set_batchIndex.find(n_batchIndex);
-          if(iter2 != member->set_batchIndex.end())
-          {
-            Tree_Member_t *member = (*iter);
-            s_val = member->s_val;
-            return ERR_None; // get the val.
-          }
-        }
+        _compare_val(val_a, val_b, n_cmp);
       }
-      return ERR_UnregisteredIndex; // not get the val.
+      return n_cmp;
     }
 
-    uint32_t _get_batchIndex(rapidxml::xml_node<>* node_batch)
+    void _sort_members(const Tree_Item_t *item_cur) const
     {
-      rapidxml::xml_attribute<>* temp_attr;
-      if((temp_attr = node_batch->first_attribute(C_strIndexTag.c_str())) != NULL) // node has index attribute.
+      if(!item_cur->is_sorted)
       {
-        char *p_char;
-        uint32_t batch_index = strtol(temp_attr->value(), &p_char, FORMAT_Batch_Index);
-        return batch_index;
+        item_cur->v_sortedMember.assign(item_cur->l_member.begin(), item_cur->l_member.end());
+        std::sort(item_cur->v_sortedMember.begin(), item_cur->v_sortedMember.end(),
+        [](const Tree_Member_t *member_a, const Tree_Member_t *member_b){
+          return _order_val(member_a->s_val, member_b->s_val) < 0;
+        });
+        item_cur->is_sorted = true;
       }
-      return 0;
     }
 
-    void _get_membersOfBatch(const Tree_Item_t* item_cur, uint32_t n_batchIndex, std::map<std::string, Tree_Val_t*> &m_batch) const
+    /**
+     * @brief This func sort the dictionaries of all items ahead of queries,
+     *        so that queries do not change the tree.
+     */
+    void _sort_itemTree() const
     {
-      if(item_cur != NULL)
+      for(size_t m = 0; m < s_itemTable.v_item.size(); m++)
       {
-        Tree_Val_t *new_val = new Tree_Val_t;
-        new_val->e_type = VAL_None;
-        _get_memberVal(item_cur, n_batchIndex, *new_val); // get the value from tree.
-        m_batch.insert(std::make_pair(item_cur->str_name, new_val)); // insert name and value into batch map.
-
-        for(auto iter=item_cur->v_childItem.begin(); iter!=item_cur->v_childItem.end(); ++iter)
+        if(s_itemTable.v_item[m]->l_member.size() > C_nMaxScanMember) // smaller ones are scanned.
         {
-          Tree_Item_t *child_item = (*iter);
-          _get_membersOfBatch(child_item, n_batchIndex, m_batch);
+          _sort_members(s_itemTable.v_item[m]);
         }
       }
     }
 
-    void _get_membersOfItem(const Tree_Item_t* item_cur, std::map<uint32_t, Tree_Val_t*> &m_item) const
+    /**
+     * @brief This func find the members matching predicate in the sorted
+     *        dictionary of item by binary search.
+     *
+     * @output n_begin, n_end: ranges [n_begin, n_end) in v_sortedMember.
+     *
+     * @ret   return number of ranges, 0 ~ 2.
+     */
+    int _get_predRanges(const Tree_Item_t *item_cur, const Tree_Pred_t &s_pred, size_t n_begin[2], size_t n_end[2]) const
     {
-      for(auto iter=item_cur->l_member.begin(); iter!=item_cur->l_member.end(); ++iter)
+      int n_rank = _get_valRank(s_pred.s_val);
+      if((n_rank != C_nRankNumber) && (n_rank != C_nRankString)) return 0; // operand is not comparable.
+      if((s_pred.e_op == PRED_Prefix) && (n_rank != C_nRankString)) return 0;
+      if((s_pred.e_op == PRED_Between) && (_get_valRank(s_pred.s_valHigh) != n_rank)) return 0;
+
+      _sort_members(item_cur);
+      typedef std::vector<Tree_Member_t *>::const_iterator Iter_t;
+      const std::vector<Tree_Member_t *> &v_sorted = item_cur->v_sortedMember;
+      Iter_t iter_first = v_sorted.begin();
+      /* the members comparable with operand. */
+      Iter_t iter_begin = std::partition_point(v_sorted.begin(), v_sorted.end(), [=](const Tree_Member_t *member){
+        return _get_valRank(member->s_val) < n_rank;
+      });
+      Iter_t iter_end = std::partition_point(iter_begin, v_sorted.end(), [=](const Tree_Member_t *member){
+        return _get_valRank(member->s_val) == n_rank;
+      });
+      auto lower = [&](const Tree_Val_t &s_val){
+        return std::lower_bound(iter_begin, iter_end, &s_val, [](const Tree_Member_t *member, const Tree_Val_t *val){
+          return _order_val(member->s_val, *val) < 0;
+        });
+      };
+      auto upper = [&](const Tree_Val_t &s_val){
+        return std::upper_bound(iter_begin, iter_end, &s_val, [](const Tree_Val_t *val, const Tree_Member_t *member){
+          return _order_val(*val, member->s_val) < 0;
+        });
+      };
+
+      Iter_t iter_from = iter_begin, iter_to = iter_end;
+      switch(s_pred.e_op)
       {
-        Tree_Member_t *member = (*iter);
-        for(auto iter2=member->set_batchIndex.begin(); iter2!=member->set_batchIndex.end(); ++iter2)
+      case PRED_Equal:
+        iter_from = lower(s_pred.s_val);
+        iter_to = upper(s_pred.s_val);
+        break;
+      case PRED_NotEqual:
+        n_begin[1] = upper(s_pred.s_val) - iter_first;
+        n_end[1] = iter_end - iter_first;
+        iter_to = lower(s_pred.s_val);
+        break;
+      case PRED_Less:
+        iter_to = lower(s_pred.s_val);
+        break;
+      case PRED_LessEqual:
+        iter_to = upper(s_pred.s_val);
+        break;
+      case PRED_Greater:
+        iter_from = upper(s_pred.s_val);
+        break;
+      case PRED_GreaterEqual:
+        iter_from = lower(s_pred.s_val);
+        break;
+      case PRED_Between:
+        iter_from = lower(s_pred.s_val);
+        iter_to = std::max(iter_from, upper(s_pred.s_valHigh));
+        break;
+      case PRED_Prefix:
         {
-          uint32_t batch_index = (*iter2);
-          Tree_Val_t* new_val = new Tree_Val_t;
-          new_val->e_type = VAL_None;
-          _get_memberVal(item_cur, batch_index, *new_val); // get the value from tree.
-          m_item.insert(std::make_pair(batch_index, new_val)); // insert batch index and value into item map.
+          size_t n_len = strlen(s_pred.s_val.u_val.val_string);
+          iter_from = lower(s_pred.s_val);
+          iter_to = std::partition_point(iter_from, iter_end, [&](const Tree_Member_t *member){
+            return !strncmp(member->s_val.u_val.val_string, s_pred.s_val.u_val.val_string, n_len);
+          });
         }
+        break;
+      default:
+        return 0;
       }
+      n_begin[0] = iter_from - iter_first;
+      n_end[0] = iter_to - iter_first;
+      return (s_pred.e_op == PRED_NotEqual) ? 2 : 1;
     }
 
-    void _delete_membersOfBatch(Tree_Item_t* item_cur, uint32_t n_bathIndex)
+    /**
+     * @ret return true if the two values are comparable (both numbers or
+     *      both strings), and n_cmp is <0, 0, >0 as val_a <, ==, > val_b.
+     */
+    static bool _compare_val(const Tree_Val_t &val_a, const Tree_Val_t &val_b, int &n_cmp)
     {
-      bool is_delete = false;
-      if(item_cur != NULL)
+      if((val_a.e_type == VAL_String) && (val_b.e_type == VAL_String))
+      {
+        n_cmp = strcmp(val_a.u_val.val_string, val_b.u_val.val_string);
+        return true;
+      }
+      if(((val_a.e_type == VAL_Int) || (val_a.e_type == VAL_Double)) && ((val_b.e_type == VAL_Int) || (val_b.e_type == VAL_Double)))
       {
-        for(auto iter=item_cur->l_member.begin(); iter!=item_cur->l_member.end(); )
+        if((val_a.e_type == VAL_Int) && (val_b.e_type == VAL_Int))
         {
-          Tree_Member_t *member = (*iter);
-          auto it = member->set_batchIndex.find(n_bathIndex);
-          if(it != member->set_batchIndex.end())
-          {
-            member->set_batchIndex.erase(it);
-            if(member->set_batchIndex.size() == 0) // this member is only owned by this index, delete the member also.
-            {
-              if(member->s_val.e_type == VAL_String)
-              {
-                delete[] member->s_val.u_val.val_string;
-              }
-              delete member;
-              is_delete = true;
-            }
-          }
-          if(is_delete)
-          {
-            iter = item_cur->l_member.erase(iter);
-          }
-          else
-          {
-            iter++;
-          }
+          n_cmp = (val_a.u_val.val_int > val_b.u_val.val_int) - (val_a.u_val.val_int < val_b.u_val.val_int);
         }
-
-        for(auto iter=item_cur->v_childItem.begin(); iter!=item_cur->v_childItem.end(); ++iter)
+        else
         {
-          Tree_Item_t *child_item = (*iter);
-          _delete_membersOfBatch(child_item, n_bathIndex);
+          double d_a = (val_a.e_type == VAL_Int) ? val_a.u_val.val_int : val_a.u_val.val_double;
+          double d_b = (val_b.e_type == VAL_Int) ? val_b.u_val.val_int : val_b.u_val.val_double;
+          if(!(d_a == d_a) || !(d_b == d_b)) return false; // NaN is not comparable.
+          n_cmp = (d_a > d_b) - (d_a < d_b);
         }
+        return true;
+      }
+      return false;
+    }
+
+    static bool _match_pred(const Tree_Val_t &s_val, const Tree_Pred_t &s_pred)
+    {
+      int n_cmp = 0;
+      if(s_pred.e_op == PRED_Prefix)
+      {
+        return (s_val.e_type == VAL_String) && (s_pred.s_val.e_type == VAL_String)
+               && !strncmp(s_val.u_val.val_string, s_pred.s_val.u_val.val_string, strlen(s_pred.s_val.u_val.val_string));
+      }
+      if(!_compare_val(s_val, s_pred.s_val, n_cmp)) return false;
+      switch(s_pred.e_op)
+      {
+      case PRED_Equal:
+        return n_cmp == 0;
+      case PRED_NotEqual:
+        return n_cmp != 0;
+      case PRED_Less:
+        return n_cmp < 0;
+      case PRED_LessEqual:
+        return n_cmp <= 0;
+      case PRED_Greater:
+        return n_cmp > 0;
+      case PRED_GreaterEqual:
+        return n_cmp >= 0;
+      case PRED_Between:
+        return (n_cmp >= 0) && _compare_val(s_val, s_pred.s_valHigh, n_cmp) && (n_cmp <= 0);
+      default:
+        return false;
       }
     }
 
@@ -778,8 +5783,26 @@ namespace xml_tree
     };
 
     const static int C_nMaxLayer;
+    const static uint32_t C_nNoItem;
     const static int C_nMaxItem;
     const static int C_nCrorNum;
+    const static int C_nStreamChunk;
+    const static size_t C_nMinPartBatch;
+    const static size_t C_nMaxScanMember;
+    const static size_t C_nDenseRatio;
+    const static uint64_t C_nDenseSpan;
+    const static uint64_t C_nRunLength;
+    const static size_t C_nRunMaxMember;
+    const static size_t C_nGroupMemberCost;
+    enum
+    {
+      C_nRankNumber = 0,
+      C_nRankNaN,
+      C_nRankString,
+      C_nRankNone,
+    };
+    const static uint32_t C_nSnapshotVersion;
+    const static std::string C_strSnapshotMagic;
     const static std::string C_strItemTag;
     const static std::string C_strIndexTag;
     const static std::string C_strNameTag;
@@ -788,13 +5811,30 @@ namespace xml_tree
     const static std::string C_strTypeTag;
     const static std::string C_arrValTypeStr[VAL_NUM];
 
+    Tree_Arena_t s_arena; // Arena of members, must be declared before items using it.
     Tree_Item_t s_rootItem; // Root item of xmlTree.
-    std::set<uint32_t> set_batchIndex; // Vector of index of all batches.
+    Tree_StrPool_t s_strPool; // Strings of values, shared by all items.
+    std::unordered_map<const char *, Tree_Item_t *, Tree_StrHash_t, Tree_StrEqual_t> um_itemName; // Map from name to item, keyed on item's own name.
+    std::unordered_map<Tree_Id_t, Tree_Item_t *> um_itemId; // Map from id to item.
+    Tree_ItemTable_t s_itemTable; // Items in pre-order.
+    Tree_Bitmap_t bm_batchIndex; // Bitmap of index of all batches.
+    std::list<Tree_FileMap_t *> l_fileMap; // Mapped snapshot files, which string values point into.
   };
 
-  const int xmlTree::C_nMaxLayer = sizeof(uint32_t) * 2; // 0x00 has 2 'bit' to use, 0x0000 has 4 'bit', and so on.
-  const int xmlTree::C_nMaxItem = FORMAT_Item_Id - 1; // 0xf, each 'bit' max is 15.
-  const int xmlTree::C_nCrorNum = 4; // 0x1 -> 0x10 need cror 4 bits.
+  const int xmlTree::C_nMaxLayer = sizeof(Tree_Id_t) * 8 / FORMAT_Item_Bits; // each layer takes FORMAT_Item_Bits bits of id.
+  const uint32_t xmlTree::C_nNoItem = 0xffffffff; // no item in link of s_itemTable.
+  const int xmlTree::C_nMaxItem = (1 << FORMAT_Item_Bits) - 1; // 0xf by default, index 0 means no item.
+  const int xmlTree::C_nCrorNum = FORMAT_Item_Bits; // 0x1 -> 0x10 need cror 4 bits by default.
+  const int xmlTree::C_nStreamChunk = 64 * 1024; // read value file by 64KB each time in stream mode.
+  const size_t xmlTree::C_nMinPartBatch = 1024; // each thread of parallel loading parses 1024 batches at least.
+  const size_t xmlTree::C_nMaxScanMember = 8; // items with fewer members are scanned instead of binary searched.
+  const size_t xmlTree::C_nDenseRatio = 16; // items with fewer batches per distinct value may be dense.
+  const uint64_t xmlTree::C_nDenseSpan = 4; // dense items have at most 4 slots per batch.
+  const uint64_t xmlTree::C_nRunLength = 8; // run items have at least 8 batches per run on average.
+  const size_t xmlTree::C_nRunMaxMember = 64; // run items have at most 64 distinct values to search.
+  const size_t xmlTree::C_nGroupMemberCost = 1024; // intersecting a member with a group costs about 1024 lookups of batch.
+  const uint32_t xmlTree::C_nSnapshotVersion = 3; // change it if format of snapshot changes.
+  const std::string xmlTree::C_strSnapshotMagic = "XTSN";
   const std::string xmlTree::C_strItemTag = "Content";
   const std::string xmlTree::C_strBatchTag = "Batch";
   const std::string xmlTree::C_strMemberTag = "Member";
@@ -802,6 +5842,205 @@ namespace xml_tree
   const std::string xmlTree::C_strNameTag = "name";
   const std::string xmlTree::C_strTypeTag = "type";
   const std::string xmlTree::C_arrValTypeStr[] = {"", "int", "string", "double"};
+
+  /**
+   * @brief This class share one xmlTree between many reader threads and
+   *        one writer thread, such as request threads getting values while
+   *        a background thread adds and deletes batches.
+   *
+   * @note  (1) It keeps two copies of the tree (left-right). Readers use
+   *            one copy while the writer changes the other, then the copies
+   *            are swapped, the writer waits for the readers still on the
+   *            old copy and repeats the change on it. Readers never lock or
+   *            wait, even during a bulk load, they only count themselves in
+   *            and out of a slot.
+   *
+   *        (2) So the memory is doubled, both copies hold all batches, and
+   *            a change is done twice. write() calls its function once on
+   *            each copy, it must change them in the same way, like the
+   *            functions of xmlTree do. add_batch_fromXmlFile() reads the
+   *            file once, but parses the xml once per copy, so loading
+   *            costs about twice as much as on one xmlTree.
+   *
+   *        (3) Handles (and get_itemName()) are different in two copies,
+   *            get them in the same read(), and use them inside it only.
+   *            Values got by read() are copied, they can be used after it,
+   *            but views (get_oneItemView()) can not.
+   *
+   *        (4) Dictionaries are sorted by the writer before the copies are
+   *            swapped, since a query sorts them on demand otherwise.
+   */
+  class xmlSharedTree
+  {
+  public:
+    xmlSharedTree() : n_readTree(0), n_version(0)
+    {
+      for(int m = 0; m < 2; m++)
+      {
+        for(size_t n = 0; n < C_nReadSlot; n++)
+        {
+          arr_readSlot[m][n].n_reader.store(0);
+        }
+      }
+    }
+
+    /**
+     * @brief This func call fn(tree) with the copy of tree for readers,
+     *        and return what fn() returns, such as
+     *        read([&](const xmlTree &tree){ return tree.get_oneItemValue("height", m_item); }).
+     *
+     * @note  (1) Any thread can read at any time, fn() must not keep the
+     *            tree, or handles of it, after return.
+     */
+    template<class Fn>
+    auto read(Fn fn) const -> decltype(fn(std::declval<const xmlTree &>()))
+    {
+      Tree_ReadGuard_t s_guard(this);
+      return fn(arr_tree[n_readTree.load()]);
+    }
+
+    /**
+     * @brief This func call fn(tree) with each copy of tree in turn to
+     *        change it, and return what fn() returns on the first copy.
+     *
+     * @note  (1) Writers are serialized, readers are not blocked.
+     */
+    template<class Fn>
+    int write(Fn fn)
+    {
+      std::lock_guard<std::mutex> s_lock(s_writeLock);
+      int n_writeTree = 1 - n_readTree.load();
+      int ret = fn(arr_tree[n_writeTree]);
+      arr_tree[n_writeTree]._sort_itemTree();
+      n_readTree.store(n_writeTree); // new readers use the changed copy.
+      _wait_readers();
+      fn(arr_tree[1 - n_writeTree]);
+      arr_tree[1 - n_writeTree]._sort_itemTree();
+      return ret;
+    }
+
+    int build_tree_fromXmlFile(const char* str_xml_name)
+    {
+      return write([&](xmlTree &tree){ return tree.build_tree_fromXmlFile(str_xml_name); });
+    }
+
+    /**
+     * @brief This func set batches of value of item by an xml file like
+     *        xmlTree::add_batch_fromXmlFile(), the file is read once for
+     *        both copies.
+     */
+    int add_batch_fromXmlFile(const char* str_xml_val)
+    {
+      rapidxml::file<> xml_file(str_xml_val);
+      return write([&](xmlTree &tree){
+        std::vector<char> v_text(xml_file.data(), xml_file.data() + xml_file.size()); // parsing changes the text.
+        return tree._add_batches(&v_text[0]);
+      });
+    }
+
+    int delete_oneBatch(uint32_t n_batchIndex)
+    {
+      return write([&](xmlTree &tree){ return tree.delete_oneBatch(n_batchIndex); });
+    }
+
+    int delete_batches(const Tree_Bitmap_t &bm_batch)
+    {
+      return write([&](xmlTree &tree){ return tree.delete_batches(bm_batch); });
+    }
+
+    void optimize()
+    {
+      write([](xmlTree &tree){ tree.optimize(); return static_cast<int>(ERR_None); });
+    }
+
+    int get_oneBatchValue(uint32_t n_batchIndex, std::map<std::string, Tree_Val_t*> &m_batch) const
+    {
+      return read([&](const xmlTree &tree){ return tree.get_oneBatchValue(n_batchIndex, m_batch); });
+    }
+
+    int get_oneItemValue(const char* str_itemName, std::map<uint32_t, Tree_Val_t*> &m_item) const
+    {
+      return read([&](const xmlTree &tree){ return tree.get_oneItemValue(str_itemName, m_item); });
+    }
+
+    void get_batchSet(std::set<uint32_t> &set_batch) const
+    {
+      read([&](const xmlTree &tree){ tree.get_batchSet(set_batch); });
+    }
+
+  private:
+    /**
+     * @note no copying!
+     */
+    xmlSharedTree(const xmlSharedTree &);
+    void operator =(const xmlSharedTree &);
+
+    /**
+     * @note  Count of readers in one slot, padded to a cache line so that
+     *        readers of different slots do not share it.
+     */
+    struct Tree_ReadSlot_t
+    {
+      std::atomic<int> n_reader;
+      char arr_pad[64 - sizeof(std::atomic<int>)];
+    };
+
+    /**
+     * @note  Counts a reader in the slot of its thread and current version
+     *        while it is alive.
+     */
+    struct Tree_ReadGuard_t
+    {
+      Tree_ReadGuard_t(const xmlSharedTree *tree)
+      {
+        size_t n_slot = std::hash<std::thread::id>()(std::this_thread::get_id()) % C_nReadSlot;
+        p_reader = &tree->arr_readSlot[tree->n_version.load()][n_slot].n_reader;
+        p_reader->fetch_add(1);
+      }
+
+      ~Tree_ReadGuard_t()
+      {
+        p_reader->fetch_sub(1);
+      }
+
+      std::atomic<int> *p_reader;
+    };
+
+    /**
+     * @brief This func wait until no reader uses the copy not for readers.
+     *
+     * @note  (1) Readers count themselves by version, not by copy, since
+     *            a reader may load the copy after the writer swapped them.
+     *            Once the other version has no reader, new readers are moved
+     *            to it, then the readers of current version are waited.
+     */
+    void _wait_readers()
+    {
+      int n_versionCur = n_version.load();
+      _wait_version(1 - n_versionCur);
+      n_version.store(1 - n_versionCur);
+      _wait_version(n_versionCur);
+    }
+
+    void _wait_version(int n_versionWait) const
+    {
+      for(size_t n = 0; n < C_nReadSlot; n++)
+      {
+        while(arr_readSlot[n_versionWait][n].n_reader.load() != 0)
+        {
+          std::this_thread::yield();
+        }
+      }
+    }
+
+    static const size_t C_nReadSlot = 16;
+
+    xmlTree arr_tree[2]; // Two copies of tree.
+    std::atomic<int> n_readTree; // Copy of tree for readers.
+    std::atomic<int> n_version; // Version that new readers count themselves in.
+    mutable Tree_ReadSlot_t arr_readSlot[2][C_nReadSlot]; // Readers by version and slot.
+    std::mutex s_writeLock; // Lock of writers.
+  };
 }
 
 namespace xml_tree